@@ -9,6 +9,8 @@
 #include "Wire.h"
 #include "FreeRTOS.h"
 #include "my_ota.h"
+#include "my_live.h"
+#include "my_glyph.h"
 #include "my_txt.h"
 
 
@@ -20,6 +22,34 @@ TaskHandle_t my_mp3_task_handle;
 #define BSP_I2C_SCL           (GPIO_NUM_2)   // SCL引脚
 int symaxnum;
 char buff[100];
+screen_state page_state;           // 翻页时拼好的屏幕状态帧
+char page_text[TXT_PAGE_SIZE];
+#if TXT_DLIST
+uint8_t page_dlist[AR_LINK_MAX_PAYLOAD / 2];
+#endif
+
+// 正文和进度条：优先发排好版的显示列表，放不下就发文本让 C3 自己排
+void screen_state_add_page(screen_state *st, const char *text, int bar){
+#if TXT_DLIST
+  size_t len = text ? txt_page_dlist(text, bar, page_dlist, sizeof(page_dlist)) : 0;
+  if (len > 0) {
+    screen_state_add_data(st, AR_LINK_DLIST, page_dlist, len);
+    return;
+  }
+#endif
+  if (text) {
+    screen_state_add(st, 'a', text);
+  }
+  screen_state_add_bar(st, bar);
+}
+
+// 翻页后把下一页用到的字发给 C3，它缺的字趁用户还在看这一页时取过去
+void prefetch_next_page(bool (*load)(const char*,int,int*,char*)){
+  int symax;
+  if(BLEServerDemo::nowpage<symaxnum && load(BLEServerDemo::nowname,BLEServerDemo::nowpage+1,&symax,page_text)){
+    glyph_prefetch(page_text);
+  }
+}
 void button_pressed(){
   Serial.println("Button pressed");
   // get_image();
@@ -54,6 +84,7 @@ void setup(void){
   my_driver_init();
   my_es8311_init();
   my_uart_init();
+  my_glyph_init();
 
   print_axp2101_status();
   // my_camera_init();
@@ -66,28 +97,35 @@ void setup(void){
 }
 
 void loop() {
+  live_text_loop();
   if(BLEServerDemo::nowthing==1){
     Serial.println(BLEServerDemo::nowname);
-    send_name(BLEServerDemo::nowname);
-    display_txt(BLEServerDemo::nowname,BLEServerDemo::nowpage,&symaxnum);
+    screen_state_begin(&page_state);
+    screen_state_add(&page_state,'c',BLEServerDemo::nowname);
+    bool ok=display_txt(BLEServerDemo::nowname,BLEServerDemo::nowpage,&symaxnum,page_text);
     if(BLEServerDemo::nowpage>symaxnum){
       BLEServerDemo::nowpage=0;
     }
     sprintf(buff,"%d/%d",BLEServerDemo::nowpage+1,symaxnum+1);
-    send_bar((BLEServerDemo::nowpage+1)*100/(symaxnum+1));
-    send_pages(buff);
+    screen_state_add_page(&page_state,ok?page_text:NULL,(BLEServerDemo::nowpage+1)*100/(symaxnum+1));
+    screen_state_add(&page_state,'b',buff);
+    send_screen_state(&page_state);    // 一帧发完，C3 只刷新一次
+    prefetch_next_page(display_txt);
     Serial.println(buff);
     BLEServerDemo::nowthing=0;
   }else if(BLEServerDemo::nowthing==2){
     Serial.println(BLEServerDemo::nowname);
-    send_name(BLEServerDemo::nowname);
-    display_json(BLEServerDemo::nowname,BLEServerDemo::nowpage,&symaxnum);
+    screen_state_begin(&page_state);
+    screen_state_add(&page_state,'c',BLEServerDemo::nowname);
+    bool ok=display_json(BLEServerDemo::nowname,BLEServerDemo::nowpage,&symaxnum,page_text);
     if(BLEServerDemo::nowpage>symaxnum){
       BLEServerDemo::nowpage=0;
     }
     sprintf(buff,"%d/%d",BLEServerDemo::nowpage+1,symaxnum+1);
-    send_bar((BLEServerDemo::nowpage+1)*100/(symaxnum+1));
-    send_pages(buff);
+    screen_state_add_page(&page_state,ok?page_text:NULL,(BLEServerDemo::nowpage+1)*100/(symaxnum+1));
+    screen_state_add(&page_state,'b',buff);
+    send_screen_state(&page_state);    // 一帧发完，C3 只刷新一次
+    prefetch_next_page(display_json);
     Serial.println(buff);
     BLEServerDemo::nowthing=0;
   }else if(BLEServerDemo::nowthing==3){
@@ -103,6 +141,22 @@ void loop() {
   }else if(BLEServerDemo::nowthing==6){
     updateFromSD();
     BLEServerDemo::nowthing=0;
+  }else if(BLEServerDemo::nowthing==7){
+    // 把最近拍的照片（JPEG）发到眼镜上显示
+    if(my_image.buf!=NULL){
+      send_image(AR_LINK_IMG_JPEG,0,0,0,0,my_image.buf,my_image.len);
+    }
+    BLEServerDemo::nowthing=0;
+  }else if(BLEServerDemo::nowthing==8){
+    send_display_bench();
+    BLEServerDemo::nowthing=0;
+  }
+  // C3 显示基准测试的结果到齐了就转给手机
+  static char bench_text[BLE_VALUE_MAX];
+  size_t bench_len=my_uart_bench_take(bench_text,sizeof(bench_text));
+  if(bench_len>0){
+    Serial.print(bench_text);
+    BLEServerDemo::send_my_data((uint8_t *)bench_text,bench_len);
   }
   button.tick();
   // axp_off();
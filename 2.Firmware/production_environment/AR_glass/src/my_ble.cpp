@@ -3,9 +3,9 @@
 #include "my_sd.h"
 #include "my_driver.h"
 #include "my_uart.h"
-#include <BLE2902.h>
 #include "my_txt.h"
 #include "my_es8311.h"
+#include "my_live.h"
 #define chunk_num 400
 
 
@@ -16,124 +16,84 @@ namespace BLEServerDemo
   static int data_len;
   static int write_data_len;
 
-  BLEServer *pServer = nullptr;
-  BLEService *pService1 = nullptr;
-  BLEService *pService2 = nullptr;
-  BLEService *pService3 = nullptr;
+  static BleTransport *transport = nullptr;
 
+  // 只写特征值的最新内容，协议层自己保存（原来直接读特征值）
+  static uint8_t file_data[BLE_VALUE_MAX];
+  static size_t  file_data_len = 0;
+  static char    file_name[256] = {0};      // 和 nowname 一样大，超长的文件名整个不收
 
-  BLECharacteristic *pCharacteristic1_1 = nullptr;
-  BLECharacteristic *pCharacteristic1_2 = nullptr;
-  BLECharacteristic *pCharacteristic1_3 = nullptr;
+  //-------------------------性能统计----------------------------//
+  static uint32_t connect_us = 0;
+  static bool     wait_first_notify = false;
 
-  BLECharacteristic *pCharacteristic2_1 = nullptr;
-  BLECharacteristic *pCharacteristic2_2 = nullptr;
-  BLECharacteristic *pCharacteristic2_3 = nullptr;
-
-  BLECharacteristic *pCharacteristic3_1 = nullptr;
-  BLECharacteristic *pCharacteristic3_2 = nullptr;
-  BLECharacteristic *pCharacteristic3_3 = nullptr;
+  static void ble_notify(ble_char_id id, const uint8_t *data, size_t len)
+  {
+    transport->notify(id, data, len);
+    if (wait_first_notify) {
+      wait_first_notify = false;
+      Serial.printf("BLE connect->first notify: %lu us\n", (unsigned long)(micros() - connect_us));
+    }
+  }
 
   void send_my_data(uint8_t *data, size_t len){
-    pCharacteristic3_3->setValue(data,len);
-    pCharacteristic3_3->notify();
+    ble_notify(BLE_CHAR_NOTIFY, data, len);
   }
   void send_my_data(std::string value){
-    pCharacteristic3_3->setValue(value);
-    pCharacteristic3_3->notify();
+    ble_notify(BLE_CHAR_NOTIFY, (const uint8_t *)value.data(), value.length());
   }
 
-  //----------------------------连接处理-------------------------//
-  class ServerCallbacks : public BLEServerCallbacks
+  static bool value_is(const uint8_t *data, size_t len, const char *str)
   {
-    void onConnect(BLEServer *pServer)
-    {
-      deviceConnected = true;
-      Serial.println("BLE connected");
-      send_ble(true);
-    }
-
-    void onDisconnect(BLEServer *pServer)
-    {
-      deviceConnected = false;
-      Serial.println("BLE disconnected");
-      send_ble(false);
-      pServer->startAdvertising(); // Restart advertising after disconnection
-    }
-  };
-
-  //------------------------------------------------------------//
+    return len == strlen(str) && memcmp(data, str, len) == 0;
+  }
 
   //-------------------------文件接收----------------------------//
-
-static uint8_t* json_data = nullptr;   // 最终缓冲区首地址
-static size_t   json_len  = 0;         // 已用长度
-static size_t   json_cap  = 0;         // 缓冲区总容量
-
-class CharacteristicCallbacks1_2 : public BLECharacteristicCallbacks
-{
-    void onWrite(BLECharacteristic* pChar) 
+  static void on_file_cmd(const uint8_t *value, size_t len)
+  {
+    // Serial.printf("Received_1_2 Value: %.*s,%d\n", len, value, len);
+    if (value_is(value, len, "start"))
     {
-        std::string value = pChar->getValue();
-        // Serial.printf("Received_1_2 Value: %s,%d\n", value.c_str(),value.length());
-        if (value=="start")
-        {
-          Serial.printf("Received_data_name: %s\n",pCharacteristic1_3->getValue().c_str());
-          start_write(pCharacteristic1_3->getValue().c_str());
-          update_write(pCharacteristic1_1->getData(),pCharacteristic1_1->getValue().length());
-        }else if(value=="update"){
-          update_write(pCharacteristic1_1->getData(),pCharacteristic1_1->getValue().length());
-        }else if(value=="end"){
-          end_write();
-          Serial.printf("Received_data_end: %s\n",pCharacteristic1_3->getValue().c_str());
-        }
+      Serial.printf("Received_data_name: %s\n", file_name);
+      start_write(file_name);
+      update_write(file_data, file_data_len);
+    }else if(value_is(value, len, "update")){
+      update_write(file_data, file_data_len);
+    }else if(value_is(value, len, "end")){
+      end_write();
+      Serial.printf("Received_data_end: %s\n", file_name);
     }
-};
+  }
   // -----------------------------------------------------------//
   //--------------------------照片发送-------------------------//
-
-  class CharacteristicCallbacks2_1 : public BLECharacteristicCallbacks
+  static void on_image_cmd(const uint8_t *value, size_t len)
   {
-    void onRead(BLECharacteristic *pCharacteristic, esp_ble_gatts_cb_param_t *param)
+    if (value_is(value, len, "getimage"))
     {
-      Serial.println("read_image_len");
-      pCharacteristic->setValue(data_len);
-    }
-  };
-  class CharacteristicCallbacks2_2 : public BLECharacteristicCallbacks
-  {
-    void onWrite(BLECharacteristic *pCharacteristic)
-    {
-      std::string value = pCharacteristic->getValue();
-      if (value == "getimage")
+      if (my_image.buf != NULL)
       {
-        if (my_image.buf != NULL)
+        if (data_len > chunk_num)
         {
-          if (data_len > chunk_num)
-          {
-            // Serial.printf("Send image size: %zu bytes\n", chunk_num);
-            pCharacteristic2_3->setValue(my_image.buf + write_data_len, chunk_num);
-            pCharacteristic2_3->notify();
-            write_data_len += chunk_num;
-            data_len -= chunk_num;
-          }
-          else
-          {
-            // Serial.printf("Send image size: %zu bytes\n", data_len);
-            pCharacteristic2_3->setValue(my_image.buf + write_data_len, data_len);
-            pCharacteristic2_3->notify();
-            write_data_len = 0;
-            data_len = 0;
-            send_my_data("image_end");
-          }
+          // Serial.printf("Send image size: %zu bytes\n", chunk_num);
+          ble_notify(BLE_CHAR_IMAGE_DATA, my_image.buf + write_data_len, chunk_num);
+          write_data_len += chunk_num;
+          data_len -= chunk_num;
+        }
+        else
+        {
+          // Serial.printf("Send image size: %zu bytes\n", data_len);
+          ble_notify(BLE_CHAR_IMAGE_DATA, my_image.buf + write_data_len, data_len);
+          write_data_len = 0;
+          data_len = 0;
+          send_my_data("image_end");
         }
-      }else if (value == "takeimage")
-      {
-        data_len = my_image.len;
-        write_data_len = 0;
       }
+    }else if (value_is(value, len, "takeimage"))
+    {
+      data_len = my_image.len;
+      write_data_len = 0;
     }
-  };
+  }
 
 
   //------------------------------------------------------------//
@@ -145,133 +105,144 @@ class CharacteristicCallbacks1_2 : public BLECharacteristicCallbacks
 
 
   //---------------------------数据获取--------------------------//
-    class CharacteristicCallbacks3_1 : public BLECharacteristicCallbacks
+  static void on_ctrl_cmd(const uint8_t *data, size_t len)
   {
-    void onRead(BLECharacteristic *pCharacteristic, esp_ble_gatts_cb_param_t *param)
-    {
-      Serial.println("read_battery_percent");
-      char nowbattery[10];
-      sprintf(nowbattery,"%d",my_driver_get_battery_percent());
-      pCharacteristic->setValue(nowbattery);
-    }
-  };
-    class CharacteristicCallbacks3_2 : public BLECharacteristicCallbacks
-  {
-    void onWrite(BLECharacteristic *pCharacteristic)
-    {
-      std::string value = pCharacteristic->getValue();
-      Serial.printf("Received_data: %s\n",value.c_str());
-      if(value=="display_txt"){
-        nowpage=0;
-        nowmode=1;
-        sprintf(nowname,"%s",pCharacteristic1_3->getData()); 
+    std::string value((const char *)data, len);
+    Serial.printf("Received_data: %s\n",value.c_str());
+    if(value=="display_txt"){
+      nowpage=0;
+      nowmode=1;
+      snprintf(nowname, sizeof(nowname), "%s", file_name);
+      nowthing=1;
+    }else if(value=="display_json"){
+      nowpage=0;
+      nowmode=2;
+      snprintf(nowname, sizeof(nowname), "%s", file_name);
+      nowthing=2;
+    }else if(value=="next_page"){
+      nowpage++;
+      if(nowmode==1){
         nowthing=1;
-      }else if(value=="display_json"){
+      }else if(nowmode==2){
+        nowthing=2;
+      }
+    }else if(value=="pre_page"){
+      nowpage--;
+      if(nowpage<0){
         nowpage=0;
-        nowmode=2;
-        sprintf(nowname,"%s",pCharacteristic1_3->getData()); 
+      }
+      if(nowmode==1){
+        nowthing=1;
+      }else if(nowmode==2){
         nowthing=2;
-      }else if(value=="next_page"){
-        nowpage++;
-        if(nowmode==1){
-          nowthing=1;
-        }else if(nowmode==2){
-          nowthing=2;
-        }
-      }else if(value=="pre_page"){
-        nowpage--;
-        if(nowpage<0){
-          nowpage=0;
-        }
-        if(nowmode==1){
-          nowthing=1;
-        }else if(nowmode==2){
-          nowthing=2;
-        }
-      }else if(value=="play_mp3"){
-        sprintf(nowname,"%s",pCharacteristic1_3->getData()); 
-        nowthing=3;
-      }else if(value=="stop_mp3"){
-        nowthing=4;
-      }else if(value=="delete_json"){
-        nowthing=5;
-      }else if(value=="ota_updata"){
-        nowthing=6;
-      }else if(value=="vol_up"){
-        vol_up();
-      }else if(value=="vol_down"){
-        vol_down();
       }
+    }else if(value=="play_mp3"){
+      snprintf(nowname, sizeof(nowname), "%s", file_name);
+      nowthing=3;
+    }else if(value=="stop_mp3"){
+      nowthing=4;
+    }else if(value=="delete_json"){
+      nowthing=5;
+    }else if(value=="ota_updata"){
+      nowthing=6;
+    }else if(value=="show_image"){
+      nowthing=7;
+    }else if(value=="display_bench"){
+      nowthing=8;
+    }else if(value=="vol_up"){
+      vol_up();
+    }else if(value=="vol_down"){
+      vol_down();
     }
-  };
-  //------------------------------------------------------------//
-  void my_ble_init()
-  {
-    BLEDevice::init("AR_GLASS");
-    pServer = BLEDevice::createServer();
-    pServer->setCallbacks(new ServerCallbacks());
-
-    pService1 = pServer->createService(BLEUUID("aabb0100-0000-1000-8000-00805f9b34fb"));
-    pService2 = pServer->createService(BLEUUID("aabb0200-0000-1000-8000-00805f9b34fb"));
-    pService3 = pServer->createService(BLEUUID("aabb0300-0000-1000-8000-00805f9b34fb"));
-
-
-    //-------------------------文件接收----------------------------//
-    pCharacteristic1_1 = pService1->createCharacteristic(
-        BLEUUID("aabb0101-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_WRITE);//数据
-
-    pCharacteristic1_2 = pService1->createCharacteristic(
-        BLEUUID("aabb0102-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_WRITE);//命令
-    pCharacteristic1_2->setCallbacks(new CharacteristicCallbacks1_2());
-
-    pCharacteristic1_3 = pService1->createCharacteristic(
-        BLEUUID("aabb0103-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_WRITE);//名字
-
-    //-----------------------------------------------------------//
-
-    //--------------------------照片发送-------------------------//
-    pCharacteristic2_1 = pService2->createCharacteristic(
-        BLEUUID("aabb0201-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_READ);//长度
-    pCharacteristic2_1->setCallbacks(new CharacteristicCallbacks2_1());
-
-    pCharacteristic2_2 = pService2->createCharacteristic(
-        BLEUUID("aabb0202-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_WRITE);//命令更新
-    pCharacteristic2_2->setCallbacks(new CharacteristicCallbacks2_2());
+  }
 
-    pCharacteristic2_3 = pService2->createCharacteristic(
-        BLEUUID("aabb0203-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_NOTIFY);//接收数据
-    pCharacteristic2_3->addDescriptor(new BLE2902());
+  //----------------------------连接处理-------------------------//
+  class GlassBleHandler : public BleHandler
+  {
+    void on_connect()
+    {
+      deviceConnected = true;
+      connect_us = micros();
+      wait_first_notify = true;
+      Serial.println("BLE connected");
+      send_ble(true);
+    }
 
-    //------------------------------------------------------------//
+    void on_disconnect()
+    {
+      deviceConnected = false;
+      wait_first_notify = false;
+      Serial.println("BLE disconnected");
+      send_ble(false);
+    }
 
-    //---------------------------数据获取--------------------------//
-    pCharacteristic3_1 = pService3->createCharacteristic(
-        BLEUUID("aabb0301-0000-1000-8000-00805f9b34fb"),//电量
-        BLECharacteristic::PROPERTY_READ);
-    pCharacteristic3_1->setCallbacks(new CharacteristicCallbacks3_1());
+    void on_write(ble_char_id id, const uint8_t *data, size_t len)
+    {
+      switch (id) {
+      case BLE_CHAR_FILE_DATA:
+        // 协议栈的长写、准备写可能比缓冲长，超长的整个丢掉，不截断成半块数据
+        if (len > sizeof(file_data)) {
+          Serial.printf("file_data 太长，丢弃: %u 字节\n", (unsigned)len);
+          break;
+        }
+        memcpy(file_data, data, len);
+        file_data_len = len;
+        break;
+      case BLE_CHAR_FILE_NAME:
+        if (len > sizeof(file_name) - 1) {
+          Serial.printf("file_name 太长，丢弃: %u 字节\n", (unsigned)len);
+          break;
+        }
+        memcpy(file_name, data, len);
+        file_name[len] = '\0';
+        break;
+      case BLE_CHAR_FILE_CMD:
+        on_file_cmd(data, len);
+        break;
+      case BLE_CHAR_IMAGE_CMD:
+        on_image_cmd(data, len);
+        break;
+      case BLE_CHAR_CTRL:
+        on_ctrl_cmd(data, len);
+        break;
+      case BLE_CHAR_LIVE:
+        live_text_push(data, len);
+        break;
+      default:
+        break;
+      }
+    }
 
-    pCharacteristic3_2 = pService3->createCharacteristic(
-        BLEUUID("aabb0302-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_WRITE);//控制命令
-    pCharacteristic3_2->setCallbacks(new CharacteristicCallbacks3_2());
+    size_t on_read(ble_char_id id, uint8_t *out, size_t cap)
+    {
+      switch (id) {
+      case BLE_CHAR_IMAGE_LEN:
+        Serial.println("read_image_len");
+        memcpy(out, &data_len, sizeof(data_len));
+        return sizeof(data_len);
+      case BLE_CHAR_BATTERY:
+        Serial.println("read_battery_percent");
+        return snprintf((char *)out, cap, "%d", my_driver_get_battery_percent());
+      case BLE_CHAR_DIAG:
+        return my_uart_link_stats((char *)out, cap);
+      default:
+        return 0;
+      }
+    }
+  };
+  //------------------------------------------------------------//
 
-    pCharacteristic3_3 = pService3->createCharacteristic(
-        BLEUUID("aabb0303-0000-1000-8000-00805f9b34fb"),
-        BLECharacteristic::PROPERTY_NOTIFY);//通知
-    pCharacteristic3_3->addDescriptor(new BLE2902()); 
-    //------------------------------------------------------------//
+  static GlassBleHandler handler;
 
-    pService1->start();
-    pService2->start();
-    pService3->start();
-    pServer->getAdvertising()->start();
+  void my_ble_init()
+  {
+    uint32_t heap = ESP.getFreeHeap();
+    transport = ble_transport_create();
+    transport->begin("AR_GLASS", &handler);
+    uint32_t used = heap - ESP.getFreeHeap();
+    Serial.printf("BLE(%s) heap used: %lu bytes, free heap: %lu bytes, boot->advertising: %lu ms\n", transport->name(),
+                  (unsigned long)used, (unsigned long)ESP.getFreeHeap(), (unsigned long)millis());
     Serial.println("Waiting for client connection...");
   }
 
-}
\ No newline at end of file
+}
@@ -2,11 +2,10 @@
 #define MY_BLE_H
 
 
-#include "Arduino.h"
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
-#include "string.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "my_ble_transport.h"
 
 namespace BLEServerDemo {
 extern int nowpage;
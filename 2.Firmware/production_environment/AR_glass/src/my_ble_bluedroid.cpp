@@ -0,0 +1,116 @@
+#include "my_ble_transport.h"
+
+#if !MY_BLE_USE_NIMBLE && !defined(MY_BLE_LOOPBACK)
+
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include <BLE2902.h>
+
+//-----------------Arduino 自带 Bluedroid 协议栈实现-----------------//
+namespace {
+
+uint8_t read_buf[BLE_VALUE_MAX];   // 回调都在 BTC 任务里串行执行，共用一个缓冲
+
+class ServerCallbacks : public BLEServerCallbacks
+{
+ public:
+  explicit ServerCallbacks(BleHandler *h) : handler(h) {}
+  void onConnect(BLEServer *pServer)
+  {
+    handler->on_connect();
+  }
+  void onDisconnect(BLEServer *pServer)
+  {
+    handler->on_disconnect();
+    pServer->startAdvertising(); // Restart advertising after disconnection
+  }
+ private:
+  BleHandler *handler;
+};
+
+class CharCallbacks : public BLECharacteristicCallbacks
+{
+ public:
+  CharCallbacks(BleHandler *h, ble_char_id i) : handler(h), id(i) {}
+  void onWrite(BLECharacteristic *pCharacteristic)
+  {
+    std::string value = pCharacteristic->getValue();
+    handler->on_write(id, (const uint8_t *)value.data(), value.length());
+  }
+  void onRead(BLECharacteristic *pCharacteristic, esp_ble_gatts_cb_param_t *param)
+  {
+    size_t n = handler->on_read(id, read_buf, sizeof(read_buf));
+    pCharacteristic->setValue(read_buf, n);
+  }
+ private:
+  BleHandler *handler;
+  ble_char_id id;
+};
+
+class BluedroidTransport : public BleTransport
+{
+ public:
+  void begin(const char *name, BleHandler *handler)
+  {
+    char uuid[37];
+    BLEDevice::init(name);
+    pServer = BLEDevice::createServer();
+    pServer->setCallbacks(new ServerCallbacks(handler));
+
+    BLEService *services[3];
+    for (int s = 0; s < ble_service_count; s++) {
+      ble_uuid_str(ble_service_table[s], uuid);
+      services[s] = pServer->createService(BLEUUID(uuid));
+    }
+    for (int i = 0; i < BLE_CHAR_COUNT; i++) {
+      const ble_char_def &def = ble_char_table[i];
+      uint32_t props = 0;
+      if (def.props & BLE_PROP_READ) props |= BLECharacteristic::PROPERTY_READ;
+      if (def.props & BLE_PROP_WRITE) props |= BLECharacteristic::PROPERTY_WRITE;
+      if (def.props & BLE_PROP_WRITE_NR) props |= BLECharacteristic::PROPERTY_WRITE_NR;
+      if (def.props & BLE_PROP_NOTIFY) props |= BLECharacteristic::PROPERTY_NOTIFY;
+
+      ble_uuid_str(def.uuid, uuid);
+      chars[i] = services[(def.service >> 8) - 1]->createCharacteristic(BLEUUID(uuid), props);
+      if (def.props & BLE_PROP_NOTIFY) {
+        chars[i]->addDescriptor(new BLE2902());
+      } else {
+        chars[i]->setCallbacks(new CharCallbacks(handler, (ble_char_id)i));
+      }
+    }
+    for (int s = 0; s < ble_service_count; s++) {
+      services[s]->start();
+    }
+    pServer->getAdvertising()->start();
+  }
+
+  void notify(ble_char_id id, const uint8_t *data, size_t len)
+  {
+    chars[id]->setValue((uint8_t *)data, len);
+    chars[id]->notify();
+  }
+
+  bool connected()
+  {
+    return pServer && pServer->getConnectedCount() > 0;
+  }
+
+  const char *name()
+  {
+    return "Bluedroid";
+  }
+
+ private:
+  BLEServer *pServer = nullptr;
+  BLECharacteristic *chars[BLE_CHAR_COUNT] = {nullptr};
+};
+
+}  // namespace
+
+BleTransport *ble_transport_create()
+{
+  return new BluedroidTransport();
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "my_ble_loopback.h"
+
+#ifdef MY_BLE_LOOPBACK
+
+void BleLoopback::notify(ble_char_id id, const uint8_t *data, size_t len)
+{
+  if (!is_connected) {
+    return;                           // 和真实协议栈一样，没连接时通知直接丢弃
+  }
+  Notification n;
+  n.id = id;
+  n.value.assign(data, data + len);
+  notifications.push_back(n);
+}
+
+void BleLoopback::connect()
+{
+  is_connected = true;
+  handler->on_connect();
+}
+
+void BleLoopback::disconnect()
+{
+  is_connected = false;
+  handler->on_disconnect();
+}
+
+void BleLoopback::write(ble_char_id id, const uint8_t *data, size_t len)
+{
+  if (len > BLE_VALUE_MAX) {
+    len = BLE_VALUE_MAX;
+  }
+  handler->on_write(id, data, len);
+}
+
+std::vector<uint8_t> BleLoopback::read(ble_char_id id)
+{
+  std::vector<uint8_t> value(BLE_VALUE_MAX);
+  value.resize(handler->on_read(id, value.data(), value.size()));
+  return value;
+}
+
+bool BleLoopback::pop_notification(Notification *out)
+{
+  if (notifications.empty()) {
+    return false;
+  }
+  *out = notifications.front();
+  notifications.pop_front();
+  return true;
+}
+
+static BleLoopback *instance = nullptr;
+
+BleTransport *ble_transport_create()
+{
+  instance = new BleLoopback();
+  return instance;
+}
+
+BleLoopback *ble_loopback()
+{
+  return instance;
+}
+
+#endif
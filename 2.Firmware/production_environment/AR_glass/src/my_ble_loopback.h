@@ -0,0 +1,44 @@
+#ifndef MY_BLE_LOOPBACK_H
+#define MY_BLE_LOOPBACK_H
+
+#include "my_ble_transport.h"
+
+#ifdef MY_BLE_LOOPBACK
+
+#include <deque>
+#include <vector>
+
+//-----------------内存回环实现，用于在 Linux 上测试协议层-----------------//
+// 测试代码扮演手机：connect()/write()/read() 驱动协议层，
+// 协议层发出的通知按顺序存在 notifications 里。
+class BleLoopback : public BleTransport
+{
+ public:
+  struct Notification {
+    ble_char_id id;
+    std::vector<uint8_t> value;
+  };
+
+  void begin(const char *name, BleHandler *handler) { this->handler = handler; }
+  void notify(ble_char_id id, const uint8_t *data, size_t len);
+  bool connected() { return is_connected; }
+  const char *name() { return "loopback"; }
+
+  void connect();
+  void disconnect();
+  void write(ble_char_id id, const uint8_t *data, size_t len);
+  std::vector<uint8_t> read(ble_char_id id);
+  bool pop_notification(Notification *out);
+
+ private:
+  BleHandler *handler = nullptr;
+  bool is_connected = false;
+  std::deque<Notification> notifications;
+};
+
+// ble_transport_create() 建的那个实例，测试代码拿它扮演手机
+BleLoopback *ble_loopback();
+
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#include "my_ble_transport.h"
+
+#if MY_BLE_USE_NIMBLE && !defined(MY_BLE_LOOPBACK)
+
+#include <NimBLEDevice.h>
+
+//-----------------NimBLE 协议栈实现，比 Bluedroid 省约 100KB RAM/Flash-----------------//
+namespace {
+
+uint8_t read_buf[BLE_VALUE_MAX];   // 回调都在 NimBLE host 任务里串行执行，共用一个缓冲
+
+class ServerCallbacks : public NimBLEServerCallbacks
+{
+ public:
+  explicit ServerCallbacks(BleHandler *h) : handler(h) {}
+  void onConnect(NimBLEServer *pServer)
+  {
+    handler->on_connect();
+  }
+  void onDisconnect(NimBLEServer *pServer)
+  {
+    handler->on_disconnect();   // 断开后 NimBLE 会自动重新广播
+  }
+ private:
+  BleHandler *handler;
+};
+
+class CharCallbacks : public NimBLECharacteristicCallbacks
+{
+ public:
+  CharCallbacks(BleHandler *h, ble_char_id i) : handler(h), id(i) {}
+  void onWrite(NimBLECharacteristic *pCharacteristic)
+  {
+    NimBLEAttValue value = pCharacteristic->getValue();
+    handler->on_write(id, value.data(), value.length());
+  }
+  void onRead(NimBLECharacteristic *pCharacteristic)
+  {
+    size_t n = handler->on_read(id, read_buf, sizeof(read_buf));
+    pCharacteristic->setValue(read_buf, n);
+  }
+ private:
+  BleHandler *handler;
+  ble_char_id id;
+};
+
+class NimbleTransport : public BleTransport
+{
+ public:
+  void begin(const char *name, BleHandler *handler)
+  {
+    char uuid[37];
+    NimBLEDevice::init(name);
+    NimBLEDevice::setMTU(BLE_VALUE_MAX + 5);   // 照片按 400 字节一包通知，需要大 MTU
+    pServer = NimBLEDevice::createServer();
+    pServer->setCallbacks(new ServerCallbacks(handler));
+
+    NimBLEService *services[3];
+    for (int s = 0; s < ble_service_count; s++) {
+      ble_uuid_str(ble_service_table[s], uuid);
+      services[s] = pServer->createService(uuid);
+    }
+    for (int i = 0; i < BLE_CHAR_COUNT; i++) {
+      const ble_char_def &def = ble_char_table[i];
+      uint32_t props = 0;
+      if (def.props & BLE_PROP_READ) props |= NIMBLE_PROPERTY::READ;
+      if (def.props & BLE_PROP_WRITE) props |= NIMBLE_PROPERTY::WRITE;
+      if (def.props & BLE_PROP_WRITE_NR) props |= NIMBLE_PROPERTY::WRITE_NR;
+      if (def.props & BLE_PROP_NOTIFY) props |= NIMBLE_PROPERTY::NOTIFY;   // 2902 描述符由 NimBLE 自动添加
+
+      ble_uuid_str(def.uuid, uuid);
+      chars[i] = services[(def.service >> 8) - 1]->createCharacteristic(uuid, props);
+      if (!(def.props & BLE_PROP_NOTIFY)) {
+        chars[i]->setCallbacks(new CharCallbacks(handler, (ble_char_id)i));
+      }
+    }
+    for (int s = 0; s < ble_service_count; s++) {
+      services[s]->start();
+    }
+    NimBLEDevice::getAdvertising()->start();
+  }
+
+  void notify(ble_char_id id, const uint8_t *data, size_t len)
+  {
+    chars[id]->setValue(data, len);
+    chars[id]->notify();
+  }
+
+  bool connected()
+  {
+    return pServer && pServer->getConnectedCount() > 0;
+  }
+
+  const char *name()
+  {
+    return "NimBLE";
+  }
+
+ private:
+  NimBLEServer *pServer = nullptr;
+  NimBLECharacteristic *chars[BLE_CHAR_COUNT] = {nullptr};
+};
+
+}  // namespace
+
+BleTransport *ble_transport_create()
+{
+  return new NimbleTransport();
+}
+
+#endif
@@ -0,0 +1,27 @@
+#include "my_ble_transport.h"
+#include <stdio.h>
+
+const uint16_t ble_service_table[] = {0x0100, 0x0200, 0x0300};
+const int ble_service_count = sizeof(ble_service_table) / sizeof(ble_service_table[0]);
+
+const ble_char_def ble_char_table[BLE_CHAR_COUNT] = {
+  //-------------------------文件接收----------------------------//
+  {0x0100, 0x0101, BLE_PROP_WRITE},                       // 数据
+  {0x0100, 0x0102, BLE_PROP_WRITE},                       // 命令
+  {0x0100, 0x0103, BLE_PROP_WRITE},                       // 名字
+  //--------------------------照片发送-------------------------//
+  {0x0200, 0x0201, BLE_PROP_READ},                        // 长度
+  {0x0200, 0x0202, BLE_PROP_WRITE},                       // 命令更新
+  {0x0200, 0x0203, BLE_PROP_NOTIFY},                      // 接收数据
+  //---------------------------数据获取--------------------------//
+  {0x0300, 0x0301, BLE_PROP_READ},                        // 电量
+  {0x0300, 0x0302, BLE_PROP_WRITE},                       // 控制命令
+  {0x0300, 0x0303, BLE_PROP_NOTIFY},                      // 通知
+  {0x0300, 0x0304, BLE_PROP_WRITE | BLE_PROP_WRITE_NR},   // 实时文本
+  {0x0300, 0x0305, BLE_PROP_READ},                        // 链路诊断
+};
+
+void ble_uuid_str(uint16_t uuid, char *out)
+{
+  snprintf(out, 37, "aabb%04x-0000-1000-8000-00805f9b34fb", uuid);
+}
@@ -0,0 +1,73 @@
+#ifndef MY_BLE_TRANSPORT_H
+#define MY_BLE_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//-----------------------BLE 传输层选择-----------------------//
+// MY_BLE_USE_NIMBLE=1   使用 NimBLE 协议栈（默认，见 platformio.ini）
+// MY_BLE_USE_NIMBLE=0   使用 Arduino 自带的 Bluedroid BLE 库
+// MY_BLE_LOOPBACK       Linux 主机上编译，使用内存回环，不依赖任何协议栈
+#ifndef MY_BLE_USE_NIMBLE
+#define MY_BLE_USE_NIMBLE 0
+#endif
+
+#define BLE_PROP_READ      0x01
+#define BLE_PROP_WRITE     0x02
+#define BLE_PROP_WRITE_NR  0x04
+#define BLE_PROP_NOTIFY    0x08
+
+#define BLE_VALUE_MAX      512     // ATT 属性值最大长度
+
+// 特征值编号，和 ble_char_table 一一对应
+enum ble_char_id {
+  BLE_CHAR_FILE_DATA,    // aabb0101 文件数据
+  BLE_CHAR_FILE_CMD,     // aabb0102 文件命令
+  BLE_CHAR_FILE_NAME,    // aabb0103 文件名字
+  BLE_CHAR_IMAGE_LEN,    // aabb0201 照片长度
+  BLE_CHAR_IMAGE_CMD,    // aabb0202 照片命令
+  BLE_CHAR_IMAGE_DATA,   // aabb0203 照片数据
+  BLE_CHAR_BATTERY,      // aabb0301 电量
+  BLE_CHAR_CTRL,         // aabb0302 控制命令
+  BLE_CHAR_NOTIFY,       // aabb0303 通知
+  BLE_CHAR_LIVE,         // aabb0304 实时文本
+  BLE_CHAR_DIAG,         // aabb0305 链路诊断（两端的帧计数、错误、延迟直方图）
+  BLE_CHAR_COUNT
+};
+
+struct ble_char_def {
+  uint16_t service;      // 服务 UUID 的 16 位部分，如 0x0100
+  uint16_t uuid;         // 特征值 UUID 的 16 位部分，如 0x0101
+  uint8_t  props;
+};
+
+extern const ble_char_def ble_char_table[BLE_CHAR_COUNT];
+extern const uint16_t ble_service_table[];
+extern const int ble_service_count;
+
+// 生成 "aabbXXXX-0000-1000-8000-00805f9b34fb"，out 至少 37 字节
+void ble_uuid_str(uint16_t uuid, char *out);
+
+// 协议层（my_ble.cpp）实现，传输层在收到事件时回调
+class BleHandler {
+ public:
+  virtual ~BleHandler() {}
+  virtual void on_connect() = 0;
+  virtual void on_disconnect() = 0;
+  virtual void on_write(ble_char_id id, const uint8_t *data, size_t len) = 0;
+  virtual size_t on_read(ble_char_id id, uint8_t *out, size_t cap) = 0;   // 返回写入 out 的字节数
+};
+
+// 传输层，只负责 GATT 服务的建立和收发
+class BleTransport {
+ public:
+  virtual ~BleTransport() {}
+  virtual void begin(const char *name, BleHandler *handler) = 0;   // 建立服务并开始广播
+  virtual void notify(ble_char_id id, const uint8_t *data, size_t len) = 0;
+  virtual bool connected() = 0;
+  virtual const char *name() = 0;                                  // 协议栈名字，打印用
+};
+
+BleTransport *ble_transport_create();   // 按编译选项返回对应实现
+
+#endif
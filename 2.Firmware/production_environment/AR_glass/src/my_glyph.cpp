@@ -0,0 +1,166 @@
+#include "my_glyph.h"
+#include "my_uart.h"
+
+// 字库文件只由字形任务读；码点表启动时读进内存，查一个字只要读偏移和记录两次 SD
+static FILE *font_fp = NULL;
+static uint16_t *font_cps = NULL;
+static uint32_t font_count = 0;
+static QueueHandle_t req_queue = NULL;
+
+static int find_glyph(uint16_t cp)
+{
+    int lo = 0, hi = (int)font_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (font_cps[mid] == cp) {
+            return mid;
+        }
+        if (font_cps[mid] < cp) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+// 把一条字形记录（带码点）写到 out，返回长度；字库里没有就写一条空记录；
+// out 放不下位图时返回 0，调用者先把攒好的帧发出去再重来
+static size_t read_glyph(uint16_t cp, uint8_t *out, size_t cap)
+{
+    if (cap < AR_GLYPH_HDR) {
+        return 0;
+    }
+    ar_link::put_u16(out, cp);
+    memset(out + 2, 0, AR_GLYPH_HDR - 2);
+    int i = font_fp ? find_glyph(cp) : -1;
+    if (i < 0) {
+        return AR_GLYPH_HDR;
+    }
+    uint8_t off[4];
+    if (fseek(font_fp, GLYPH_FILE_HDR + font_count * 2 + i * 4, SEEK_SET) != 0 || fread(off, 1, 4, font_fp) != 4 ||
+        fseek(font_fp, ar_link::get_u32(off), SEEK_SET) != 0 || fread(out + 2, 1, AR_GLYPH_HDR - 2, font_fp) != AR_GLYPH_HDR - 2) {
+        Serial.printf("字库读取失败: U+%04X\n", cp);
+        memset(out + 2, 0, AR_GLYPH_HDR - 2);
+        return AR_GLYPH_HDR;
+    }
+    uint8_t box_w = out[3], box_h = out[4];
+    if (box_w > AR_GLYPH_BOX_MAX || box_h > AR_GLYPH_BOX_MAX) {
+        memset(out + 2, 0, AR_GLYPH_HDR - 2);
+        return AR_GLYPH_HDR;
+    }
+    size_t n = ar_link::glyph_bitmap_len(box_w, box_h);
+    if (AR_GLYPH_HDR + n > cap) {
+        return 0;
+    }
+    if (fread(out + AR_GLYPH_HDR, 1, n, font_fp) != n) {
+        memset(out + 2, 0, AR_GLYPH_HDR - 2);
+        return AR_GLYPH_HDR;
+    }
+    return AR_GLYPH_HDR + n;
+}
+
+// 把队列里攒着的请求一起查，尽量拼进同一帧
+static void glyph_task(void *arg)
+{
+    static uint8_t frame[AR_LINK_MAX_PAYLOAD];
+    uint16_t cp;
+    for (;;) {
+        if (!xQueueReceive(req_queue, &cp, portMAX_DELAY)) {
+            continue;
+        }
+        uint32_t t0 = millis();
+        int count = 0;
+        size_t len = 0;
+        do {
+            size_t n = read_glyph(cp, frame + len, sizeof(frame) - len);
+            if (n == 0) {
+                send_hex(AR_LINK_GLYPH, (char *)frame, len);
+                len = 0;
+                n = read_glyph(cp, frame, sizeof(frame));
+            }
+            len += n;
+            count++;
+        } while (xQueueReceive(req_queue, &cp, 0));
+        send_hex(AR_LINK_GLYPH, (char *)frame, len);
+        LINK_LOG("字形: 发出 %d 个, %lu ms\n", count, (unsigned long)(millis() - t0));
+    }
+}
+
+void glyph_request(const uint8_t *cps, size_t len)
+{
+    if (!req_queue) {
+        return;
+    }
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint16_t cp = ar_link::get_u16(cps + i);
+        if (xQueueSend(req_queue, &cp, 0) != pdTRUE) {
+            break;                                   // 队列满，C3 等不到会再要
+        }
+    }
+}
+
+void glyph_prefetch(const char *text)
+{
+    static uint16_t set[GLYPH_SET_MAX];
+    size_t count = 0;
+    size_t len = strlen(text);
+    for (size_t i = 0; i < len && count < GLYPH_SET_MAX;) {
+        uint32_t cp;
+        i += ar_link::utf8_decode((const uint8_t *)text + i, len - i, &cp);
+        if (cp < 0x80 || cp > 0xffff) {
+            continue;
+        }
+        size_t k = 0;
+        while (k < count && set[k] != cp) {
+            k++;
+        }
+        if (k == count) {
+            set[count++] = (uint16_t)cp;
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+    uint8_t buf[GLYPH_SET_MAX * 2];
+    for (size_t k = 0; k < count; k++) {
+        ar_link::put_u16(buf + k * 2, set[k]);
+    }
+    send_hex(AR_LINK_GLYPH_SET, (char *)buf, count * 2);
+}
+
+static void glyph_font_open()
+{
+    font_fp = fopen(GLYPH_FONT_PATH, "rb");
+    if (!font_fp) {
+        Serial.printf("没有字库 %s，缺的字只能显示方框\n", GLYPH_FONT_PATH);
+        return;
+    }
+    uint8_t hdr[GLYPH_FILE_HDR];
+    if (fread(hdr, 1, sizeof(hdr), font_fp) != sizeof(hdr) || memcmp(hdr, "AGF1", 4) != 0 || hdr[12] != 4) {
+        Serial.printf("字库格式不对\n");
+        fclose(font_fp);
+        font_fp = NULL;
+        return;
+    }
+    uint32_t count = ar_link::get_u32(hdr + 4);
+    font_cps = (uint16_t *)malloc(count * 2);
+    if (!font_cps || fread(font_cps, 2, count, font_fp) != count) {   // 文件里是小端，和 S3 一致
+        Serial.printf("字库码点表读取失败: %lu 个\n", (unsigned long)count);
+        free(font_cps);
+        font_cps = NULL;
+        fclose(font_fp);
+        font_fp = NULL;
+        return;
+    }
+    font_count = count;
+    Serial.printf("字库: %lu 个字, 行高 %d, 码点表 %lu 字节\n", (unsigned long)count, ar_link::get_u16(hdr + 8), (unsigned long)count * 2);
+}
+
+// 在 my_sd_init() 之后调用；没有字库也启动字形任务，给 C3 回空记录让它别再要
+void my_glyph_init()
+{
+    glyph_font_open();
+    req_queue = xQueueCreate(GLYPH_REQ_QUEUE, sizeof(uint16_t));
+    xTaskCreate(glyph_task, "glyph", 1024 * 4, NULL, 5, NULL);
+}
@@ -0,0 +1,29 @@
+#ifndef __MY_GLYPH_H
+#define __MY_GLYPH_H
+
+#include "Arduino.h"
+
+//-----------------字形服务：C3 缺的字从 SD 卡字库里取出来发过去-----------------//
+// 字库文件（tools/mkglyph.py 从 TTF 生成，字号要和 C3 上的 lv_font_AlibabaPuHuiTi_20 一致）：
+//magic          4 byte          "AGF1"
+//count          4 byte          字形个数
+//line_height    2 byte          只用来核对
+//base_line      2 byte
+//bpp            1 byte          固定 4
+//reserved       3 byte
+//cps            count*2 byte    码点，从小到大，启动时整个读进内存二分查找
+//offsets        count*4 byte    每个字形记录在文件里的偏移
+//records                        字宽(1) + box_w(1) + box_h(1) + ofs_x(1) + ofs_y(1) + 位图，
+//                               就是 ar_link.h 里的字形记录去掉码点，读出来原样发给 C3
+// 多字节都是低字节在前。
+
+#define GLYPH_FONT_PATH   "/sdcard/font/glyph20.agf"
+#define GLYPH_FILE_HDR    16
+#define GLYPH_REQ_QUEUE   256     // 等着查 SD 的码点
+#define GLYPH_SET_MAX     256     // 一页最多预取这么多个不同的字
+
+void my_glyph_init();
+void glyph_request(const uint8_t *cps, size_t len);   // 串口接收任务收到 GLYPH_REQ 时调用，只入队
+void glyph_prefetch(const char *text);               // 把这段文本用到的非 ASCII 字发给 C3 预取
+
+#endif
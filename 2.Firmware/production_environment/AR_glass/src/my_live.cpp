@@ -0,0 +1,169 @@
+#include "my_live.h"
+#include "my_uart.h"
+
+static portMUX_TYPE live_mux = portMUX_INITIALIZER_UNLOCKED;
+
+//---------------------BLE 回调写入，loop 取走----------------------//
+static char            live_pending[LIVE_TEXT_MAX];
+static volatile size_t live_pending_len = 0;
+static volatile bool   live_reset = false;      // 收到 S，需要整屏替换
+static volatile bool   live_end = false;        // 收到 E
+static volatile bool   live_path_new = false;   // 收到 P
+static char            live_path[64];
+
+//---------------------以下只在 loop 里访问--------------------------//
+static char   live_screen[LIVE_SCREEN_MAX + 1];   // 屏幕当前内容的镜像
+static size_t live_screen_len = 0;
+static char   live_carry[4];                      // 被 BLE 分包截断的 UTF-8 尾巴
+static size_t live_carry_len = 0;
+static FILE  *live_fp = nullptr;                  // 持久化文件
+
+void live_text_push(const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    char op = (char)data[0];
+    data++;
+    len--;
+
+    portENTER_CRITICAL(&live_mux);
+    switch (op) {
+    case 'S':
+        live_pending_len = 0;
+        live_reset = true;
+        /* fall through */
+    case 'A': {
+        size_t n = LIVE_TEXT_MAX - live_pending_len;   // loop 来不及取时丢弃多余部分
+        if (len < n) n = len;
+        memcpy(live_pending + live_pending_len, data, n);
+        live_pending_len += n;
+        break;
+    }
+    case 'P': {
+        size_t n = len < sizeof(live_path) - 1 ? len : sizeof(live_path) - 1;
+        memcpy(live_path, data, n);
+        live_path[n] = '\0';
+        live_path_new = true;
+        break;
+    }
+    case 'E':
+        live_end = true;
+        break;
+    default:
+        break;
+    }
+    portEXIT_CRITICAL(&live_mux);
+}
+
+// 返回 buf 中完整 UTF-8 字符的字节数，末尾不完整的字符留到下一包
+static size_t utf8_complete_len(const char *buf, size_t len)
+{
+    size_t i = len;
+    while (i > 0 && len - i < 4) {
+        uint8_t c = (uint8_t)buf[--i];
+        if ((c & 0xC0) == 0x80) {
+            continue;                                  // 后续字节，继续往前找首字节
+        }
+        size_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        return (len - i >= need) ? len : i;
+    }
+    return len;
+}
+
+// 把新文本接到屏幕镜像后面，超出 LIVE_SCREEN_MAX 时从前面按行丢弃
+static void live_screen_append(const char *s, size_t len)
+{
+    size_t over = live_screen_len + len > LIVE_SCREEN_MAX ? live_screen_len + len - LIVE_SCREEN_MAX : 0;
+    if (over >= live_screen_len) {                     // 旧内容全部丢弃，新文本也要截掉开头
+        s += over - live_screen_len;
+        len -= over - live_screen_len;
+        live_screen_len = 0;
+        while (len > 0 && ((uint8_t)*s & 0xC0) == 0x80) {
+            s++;
+            len--;
+        }
+    } else if (over > 0) {
+        char *end = live_screen + live_screen_len;
+        char *cut = live_screen + over;
+        char *nl = (char *)memchr(cut, '\n', end - cut);   // 尽量从整行处截断
+        if (nl) {
+            cut = nl + 1;
+        } else {
+            while (cut < end && ((uint8_t)*cut & 0xC0) == 0x80) cut++;
+        }
+        live_screen_len = end - cut;
+        memmove(live_screen, cut, live_screen_len);
+    }
+    memcpy(live_screen + live_screen_len, s, len);
+    live_screen_len += len;
+    live_screen[live_screen_len] = '\0';
+}
+
+void live_text_loop()
+{
+    static char chunk[sizeof(live_carry) + LIVE_TEXT_MAX + 1];
+
+    if (!live_pending_len && !live_reset && !live_end && !live_path_new) {
+        return;
+    }
+
+    bool reset, end, path_new;
+    char path[sizeof(live_path)];
+    portENTER_CRITICAL(&live_mux);
+    reset = live_reset;
+    end = live_end;
+    path_new = live_path_new;
+    if (reset) {
+        live_carry_len = 0;
+    }
+    memcpy(chunk, live_carry, live_carry_len);
+    memcpy(chunk + live_carry_len, live_pending, live_pending_len);
+    size_t total = live_carry_len + live_pending_len;
+    if (path_new) {
+        memcpy(path, live_path, sizeof(path));
+    }
+    live_pending_len = 0;
+    live_reset = live_end = live_path_new = false;
+    portEXIT_CRITICAL(&live_mux);
+
+    size_t whole = end ? total : utf8_complete_len(chunk, total);
+    live_carry_len = total - whole;
+    memcpy(live_carry, chunk + whole, live_carry_len);
+    chunk[whole] = '\0';
+
+    //---------------先上屏，落盘放在后面----------------//
+    if (reset) {
+        live_screen_len = 0;
+        live_screen_append(chunk, whole);
+        send_live_set(live_screen);
+    } else if (whole > 0) {
+        if (live_screen_len + whole > LIVE_SCREEN_MAX) {
+            live_screen_append(chunk, whole);
+            send_live_set(live_screen);
+        } else {
+            live_screen_append(chunk, whole);
+            send_live_append(chunk);
+        }
+    }
+
+    if (path_new) {
+        if (live_fp) {
+            fclose(live_fp);
+        }
+        char full[80];
+        snprintf(full, sizeof(full), "/sdcard%s", path);
+        live_fp = fopen(full, "w");
+        if (!live_fp) {
+            Serial.printf("live: fopen %s failed\n", full);
+        } else {
+            fwrite(live_screen, 1, live_screen_len, live_fp);   // 补上已经显示的部分
+        }
+    } else if (live_fp && whole > 0) {
+        fwrite(chunk, 1, whole, live_fp);
+    }
+    if (end && live_fp) {
+        fclose(live_fp);
+        live_fp = nullptr;
+    }
+}
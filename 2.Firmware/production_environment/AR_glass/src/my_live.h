@@ -0,0 +1,21 @@
+#ifndef __MY_LIVE_H
+#define __MY_LIVE_H
+
+#include "Arduino.h"
+
+//-----------------实时文本（不经过SD卡直接推送到屏幕）-----------------//
+//op             1 byte          操作位
+//text           n byte          UTF-8 文本
+//---------------------操作表------------------------------//
+//               S            新的一段文本，替换屏幕内容
+//               A            追加文本（流式输出）
+//               P            持久化到SD卡，后面跟文件路径
+//               E            本段结束，关闭持久化文件
+
+#define LIVE_TEXT_MAX    1024   // BLE 回调与 loop 之间的待发送缓冲
+#define LIVE_SCREEN_MAX  600    // 屏幕上最多保留的字节数，超出后丢弃最前面的行
+
+void live_text_push(const uint8_t *data, size_t len);   // BLE 回调里调用，只做拷贝
+void live_text_loop();                                   // loop 里调用，负责串口发送和落盘
+
+#endif
@@ -248,7 +248,7 @@ void delete_json_file() {
 }
 
 
-void display_json(const char* jsonname,int y,int* symax) { 
+bool display_json(const char* jsonname,int y,int* symax,char* page) { 
     char sypath[256];
     char txtpath[256];
     sprintf(sypath, "%s.sy", jsonname);
@@ -258,7 +258,7 @@ void display_json(const char* jsonname,int y,int* symax) {
         suoyin_creat(txtpath,sypath);
         }else{
             Serial.printf("json转换txt失败\n");
-            return;
+            return false;
         }
     }
     *symax=get_total_pages(sypath);
@@ -266,15 +266,14 @@ void display_json(const char* jsonname,int y,int* symax) {
     for (int i = 0; i < TXT_LINES; i++) {
         Serial.printf("%s\n", txt[i]);
     }
-    char str[TXT_LINES*(TXT_LINE_LENGTH + 1)];
-    sprintf(str,"%s\n%s\n%s\n%s\n%s\n%s",txt[0],txt[1],txt[2],txt[3],txt[4],txt[5]);
-    send_content(str);
+    snprintf(page,TXT_PAGE_SIZE,"%s\n%s\n%s\n%s\n%s\n%s",txt[0],txt[1],txt[2],txt[3],txt[4],txt[5]);
+    return true;
 }
-void display_txt(const char* txtname,int y,int* symax) { 
+bool display_txt(const char* txtname,int y,int* symax,char* page) { 
     Serial.println(txtname);
     if(!SD_MMC.exists(txtname)){
         Serial.printf("文件不存在\n");
-        return;
+        return false;
     }
     char sypath[256];
     char txtpath[256];
@@ -291,9 +290,8 @@ void display_txt(const char* txtname,int y,int* symax) {
     for (int i = 0; i < TXT_LINES; i++) {
         Serial.printf("%s\n", txt[i]);
     }
-    char str[TXT_LINES*(TXT_LINE_LENGTH + 1)];
-    sprintf(str,"%s\n%s\n%s\n%s\n%s\n%s",txt[0],txt[1],txt[2],txt[3],txt[4],txt[5]);
-    send_content(str);
+    snprintf(page,TXT_PAGE_SIZE,"%s\n%s\n%s\n%s\n%s\n%s",txt[0],txt[1],txt[2],txt[3],txt[4],txt[5]);
+    return true;
 }
 
 
@@ -320,3 +318,41 @@ int get_total_pages(const char* syfilepath)
     fclose(f);
     return max_page;   // 就是总页数
 }
+
+
+//------------------------------显示列表----------------------------------//
+// 每行按估算的字宽超出版面时折到下一行，和 label 的自动换行效果一样；
+// 每行在版面里居中，由 C3 按真实字宽对齐，这边的估算只用来决定在哪里折行。
+// 放不下（英文多的页码点也多）时返回 0，由调用者改发文本。
+size_t txt_page_dlist(const char* page,int bar,uint8_t* out,size_t cap)
+{
+    size_t len = 0;
+    int y = TXT_AREA_Y;
+    const char* p = page;
+    while (*p && y + TXT_LINE_H <= TXT_AREA_Y + TXT_AREA_H) {
+        const char* start = p;
+        int w = 0;
+        while (*p && *p != '\n') {
+            uint8_t c = (uint8_t)*p;
+            int n = c < 0x80 ? 1 : (c & 0xe0) == 0xc0 ? 2 : (c & 0xf0) == 0xe0 ? 3 : 4;
+            n = strnlen(p, n);                 // 页尾被截断的半个字
+            int cw = n >= 3 ? TXT_CJK_W : TXT_CJK_W / 2;
+            if (w + cw > TXT_AREA_W) {
+                break;
+            }
+            w += cw;
+            p += n;
+        }
+        size_t next = ar_link::dl_text(out, len, cap, TXT_AREA_X, y, TXT_AREA_W, AR_DL_ALIGN_CENTER, start, p - start);
+        if (next == len) {
+            Serial.printf("显示列表放不下第 %d 行\n", (y - TXT_AREA_Y) / TXT_LINE_H + 1);
+            return 0;
+        }
+        len = next;
+        y += TXT_LINE_H;
+        if (*p == '\n') {
+            p++;
+        }
+    }
+    return ar_link::dl_bar(out, len, cap, TXT_BAR_X, TXT_BAR_Y, TXT_BAR_W, TXT_BAR_H, bar);
+}
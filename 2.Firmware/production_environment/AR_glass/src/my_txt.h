@@ -6,6 +6,21 @@
 
 #define TXT_LINES 6
 #define TXT_LINE_LENGTH 60
+#define TXT_PAGE_SIZE (TXT_LINES*(TXT_LINE_LENGTH + 1))   // 一页文本拼好后的大小
+
+// 翻页时正文的发法：1 在这边排好版发显示列表 'o'，C3 直接画；0 发整段文本 'a'，由 C3 的 label 排版
+#define TXT_DLIST 1
+// 显示列表的版面，和 C3 上 screen_label_1 / screen_bar_1 的位置一致（逻辑坐标）
+#define TXT_AREA_X      0
+#define TXT_AREA_Y      100
+#define TXT_AREA_W      480
+#define TXT_AREA_H      280
+#define TXT_LINE_H      28     // 20 号字的行高
+#define TXT_CJK_W       20     // 估算字宽：中文一个字 20，其他字符按一半算
+#define TXT_BAR_X       350
+#define TXT_BAR_Y       10
+#define TXT_BAR_W       100
+#define TXT_BAR_H       25
 
 
 int json2txt(const char* path,const char* outpath);
@@ -14,7 +29,10 @@ void get_txt(const char* txtpath, const char* syfilepath ,int Y);
 
 
 void delete_json_file();//删除全部json文件
-void display_json(const char* jsonname,int y,int* symax);
-void display_txt(const char* txtname,int y,int* symax);
+// 读出第 y 页拼到 page（TXT_PAGE_SIZE 字节），由调用者和页码、进度条一起发送，失败返回 false
+bool display_json(const char* jsonname,int y,int* symax,char* page);
+bool display_txt(const char* txtname,int y,int* symax,char* page);
+// 把拼好的一页排成显示列表（居中的文字行 + 进度条）写到 out，返回长度，放不下返回 0
+size_t txt_page_dlist(const char* page,int bar,uint8_t* out,size_t cap);
 int get_total_pages(const char* syfilepath);
 #endif
\ No newline at end of file
@@ -1,93 +1,488 @@
 #include "my_uart.h"
+#include "driver/uart.h"
+#include "ar_link_stats.h"
+#include "my_glyph.h"
 
-void onDataReceived()
+static ar_link::Parser<> rx_parser;
+static SemaphoreHandle_t tx_lock = NULL;   // BLE 回调和 loop 都会发送，整帧加锁
+static uint8_t tx_seq = 0;
+
+static QueueHandle_t uart_queue = NULL;    // UART 驱动的事件队列
+static QueueHandle_t ctrl_queue = NULL;    // 链路控制应答，交给协商任务
+static TaskHandle_t link_task_handle = NULL;
+static uint32_t link_baud = AR_LINK_BAUD_DEFAULT;
+static uint32_t garbage_ms = 0;            // 非默认波特率下开始收到乱码的时间，0 表示没有
+
+//------------------------------发送队列----------------------------------//
+// 显示帧先进队列，有信用才发出去；C3 渲染完一帧回一个 ACK 归还信用。
+// 队列里还没发出去的旧帧会被同类型的新帧作废，快速翻页时不会积压。
+// 队列和线上的发送都由 tx_lock 保护。
+struct tx_slot
 {
-      // 处理接收到的数据
-      char data[9];
-      while (Serial1.available())
+    uint8_t type;
+    uint16_t len;
+    uint32_t us;                            // 进队列的时间
+    uint8_t data[AR_LINK_MAX_PAYLOAD];
+};
+static tx_slot tx_slots[LINK_TXQ_SLOTS];
+static uint8_t txq[LINK_TXQ_SLOTS];         // 按发送顺序排的槽位号
+static int txq_count = 0;
+static int credits = AR_LINK_CREDITS;
+static bool negotiating = false;            // 协商期间两端的波特率可能对不上，显示帧只排队不发
+static int inflight = 0;                    // 已发出还没收到 ACK 的显示帧
+static uint32_t ack_wait_ms = 0;            // 上一次收到 ACK（或从空闲开始发帧）的时间
+static uint32_t sent_us[256];               // 按 seq 记录发出时间，算端到端延迟
+static uint32_t superseded = 0;             // 被新帧作废的帧数
+static uint32_t last_tx_ms = 0;             // 上一帧写进发送缓冲的时间，空闲久了先发唤醒字节
+
+static ar_link::LinkStats link_stats;       // 本端统计
+static ar_link::LinkStats c3_stats;         // C3 最近一次上报的统计
+static bool c3_stats_valid = false;
+static uint8_t c3_thermal[AR_LINK_THERMAL_LEN];   // C3 最近一次上报的面板温度、亮度、电流和降档级别
+static bool c3_thermal_valid = false;
+static uint8_t c3_bench[AR_BENCH_SCENES][AR_LINK_BENCH_LEN];   // C3 显示基准测试各场景的结果
+static uint8_t c3_bench_mask = 0;
+static volatile bool c3_bench_done = false;      // 最后一个场景到了，等 loop 取走
+
+static void link_reset_credits();
+static void link_on_ack(const uint8_t *ack);
+
+struct link_ctrl_evt
+{
+    uint8_t type;
+    uint32_t value;
+    uint32_t us;       // 收到的时间
+};
+
+static void on_frame(const ar_link::Frame &frame)
+{
+      ESP_LOGI(TAG, "接收成功:cmd:%c,data_len=%d ", frame.type, (int)frame.len);
+      garbage_ms = 0;
+      AR_STAT(ar_link::stats_count(link_stats.rx_frames, link_stats.rx_bytes, frame.type, frame.len));
+      switch (frame.type)
       {
-            Serial1.readBytes(data,9);
-            char cmd = data[0];
-            int data_len = atoi(data + 1);
-            ESP_LOGI(TAG, "接收成功:cmd:%c,data_len=%d ", cmd, data_len);
-            char *newdata = (char *)malloc(data_len);
-            if (data == NULL)
-            {
-                Serial.printf("malloc failed");
-                return;
+      case AR_LINK_STATS_REPORT:
+          if (frame.len == sizeof(c3_stats) && ar_link::get_u32(frame.data) == sizeof(c3_stats)) {
+              memcpy(&c3_stats, frame.data, sizeof(c3_stats));
+              c3_stats_valid = true;
+          }
+          break;
+      case AR_LINK_THERMAL:
+          if (frame.len >= AR_LINK_THERMAL_LEN) {
+              memcpy(c3_thermal, frame.data, sizeof(c3_thermal));
+              c3_thermal_valid = true;
+          }
+          break;
+      case AR_LINK_BENCH_RESULT:
+          if (frame.len >= AR_LINK_BENCH_LEN && frame.data[0] < AR_BENCH_SCENES) {
+              memcpy(c3_bench[frame.data[0]], frame.data, AR_LINK_BENCH_LEN);
+              c3_bench_mask |= 1 << frame.data[0];
+              if (frame.data[0] == AR_BENCH_SCENES - 1) {
+                  c3_bench_done = true;
+              }
+          }
+          break;
+      case AR_LINK_HELLO:
+          // C3 刚上电，还在默认波特率，重新协商；之前在途的帧都没了，信用收回来
+          link_reset_credits();
+          xTaskNotifyGive(link_task_handle);
+          break;
+      case AR_LINK_ACK:
+          if (frame.len >= AR_LINK_ACK_LEN) {
+              link_on_ack(frame.data);
+          }
+          break;
+      case AR_LINK_GLYPH_REQ:
+          glyph_request(frame.data, frame.len);       // 只入队，查 SD 在字形任务里
+          break;
+      case AR_LINK_BAUD_ACK:
+      case AR_LINK_PONG: {
+          link_ctrl_evt evt = {frame.type, frame.len >= 4 ? ar_link::get_u32(frame.data) : 0, (uint32_t)micros()};
+          xQueueSend(ctrl_queue, &evt, 0);
+          break;
+      }
+      case 'a':
+          LINK_LOG("接收string:%.*s", (int)frame.len, frame.data);
+          break;
+      case 'g':
+          LINK_LOG("接收json:%.*s", (int)frame.len, frame.data);
+          break;
+      case 'h':
+          LINK_LOG("接收txt:%.*s", (int)frame.len, frame.data);
+          break;
+
+      default:
+          break;
+      }
+}
+
+//------------------------------接收任务----------------------------------//
+static void uart_rx_task(void *arg)
+{
+    uart_event_t event;
+    uint8_t buf[256];
+    for (;;) {
+        if (!xQueueReceive(uart_queue, &event, portMAX_DELAY)) {
+            continue;
+        }
+        switch (event.type) {
+        case UART_DATA: {
+            uint32_t frames = rx_parser.stats().frames;
+            size_t n = 0;
+            uart_get_buffered_data_len(LINK_UART, &n);
+            while (n > 0) {
+                int r = uart_read_bytes(LINK_UART, buf, n < sizeof(buf) ? n : sizeof(buf), 0);
+                if (r <= 0) break;
+                rx_parser.feed(buf, r, on_frame);
+                n -= r;
             }
-            Serial1.readBytes(newdata,data_len);
-            switch (cmd)
-            {
-            case 'a':
-                /* code */
-                newdata[data_len]='\0';
-                Serial.printf( "接收string:%s", newdata);
-                break;
-            case 'b':
-                /* code */
-                break;
-            case 'c':
-                /* code */
-                break;
-            case 'd':
-                /* code */
-                break;
-            case 'e':
-                /* code */
-                break;
-            case 'f':
-                /* code */
-                break;
-            case 'g':
-                /* code */
-                newdata[data_len]='\0';
-                Serial.printf("接收json:%s", newdata);
-                break;
-            case 'h':
-                /* code */
-                newdata[data_len]='\0';
-                Serial.printf("接收txt:%s", newdata);
-                break;
+            // 非默认波特率下一直只收到乱码，说明 C3 复位了或者时钟对不上，退回默认波特率重新协商
+            if (link_baud != AR_LINK_BAUD_DEFAULT && rx_parser.stats().frames == frames) {
+                if (garbage_ms == 0) {
+                    garbage_ms = millis();
+                } else if (millis() - garbage_ms > AR_LINK_GARBAGE_MS) {
+                    garbage_ms = 0;
+                    xTaskNotifyGive(link_task_handle);
+                }
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            Serial.printf("uart rx overflow\n");
+            uart_flush_input(LINK_UART);
+            xQueueReset(uart_queue);
+            break;
+        default:
+            break;
+        }
+    }
+}
 
-            default:
+// C3 可能已经进了浅睡眠，先发一段唤醒字节，帧本身不会丢在它醒来的过程里（见 ar_link.h），调用者持有 tx_lock
+static void link_wake()
+{
+    uint8_t wake[32];
+    memset(wake, AR_LINK_WAKE_BYTE, sizeof(wake));
+    size_t n = ar_link::wake_len(link_baud);
+    while (n > 0) {
+        size_t k = n < sizeof(wake) ? n : sizeof(wake);
+        uart_write_bytes(LINK_UART, wake, k);
+        n -= k;
+    }
+}
+
+// 写一帧到驱动的发送缓冲，调用者持有 tx_lock
+static void link_write(uint8_t cmd, const void *data, size_t data_len)
+{
+    if (millis() - last_tx_ms > AR_LINK_WAKE_IDLE_MS) {
+        link_wake();
+    }
+    last_tx_ms = millis();
+    uint8_t header[AR_LINK_HEADER_MAX];
+    uint8_t seq = tx_seq++;
+    size_t hlen = ar_link::encode_header(header, cmd, seq, data_len);
+    uint16_t crc = ar_link::frame_crc(header, hlen, data, data_len);
+    uint8_t tail[AR_LINK_CRC_LEN] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+    uart_write_bytes(LINK_UART, header, hlen);      // 只是拷进发送环形缓冲，不等发完
+    if (data_len > 0) {
+        uart_write_bytes(LINK_UART, data, data_len);
+    }
+    uart_write_bytes(LINK_UART, tail, sizeof(tail));
+    sent_us[seq] = micros();
+    AR_STAT(ar_link::stats_count(link_stats.tx_frames, link_stats.tx_bytes, cmd, data_len));
+    LINK_LOG("发送成功:cmd:%c,data_len=%d ", cmd, (int)data_len);
+}
+
+static void txq_remove(int i)
+{
+    txq_count--;
+    memmove(txq + i, txq + i + 1, txq_count - i);
+}
+
+// 有信用、不在协商就把队首的帧发出去，调用者持有 tx_lock
+static void txq_pump()
+{
+    while (!negotiating && credits > 0 && txq_count > 0) {
+        tx_slot *slot = &tx_slots[txq[0]];
+        AR_STAT(ar_link::stats_hist(link_stats.process, micros() - slot->us));
+        link_write(slot->type, slot->data, slot->len);
+        slot->len = 0xffff;                          // 槽位空闲
+        txq_remove(0);
+        credits--;
+        if (inflight++ == 0) {
+            ack_wait_ms = millis();
+        }
+    }
+}
+
+// 追加文本、图片和字形是连续的数据流，一帧都不能少，队列满时等信用而不是丢弃
+static bool is_stream(uint8_t cmd)
+{
+    return cmd == 'k' || cmd == AR_LINK_IMG_BEGIN || cmd == AR_LINK_IMG_DATA || cmd == AR_LINK_GLYPH;
+}
+
+// 数据流不能作废；'j' 整体替换，排在前面的追加也一起作废；其他命令都是设置整个字段
+static bool supersedes(uint8_t cmd, uint8_t queued)
+{
+    if (cmd == 'j' && queued == 'k') return true;
+    if (is_stream(cmd) || is_stream(queued)) return false;
+    return queued == cmd;
+}
+
+void my_tcp_send(char cmd, const char *data, int data_len)
+{
+    uint8_t type = (uint8_t)cmd;
+    if (data_len > AR_LINK_MAX_PAYLOAD) {
+        Serial.printf("帧太长，丢弃: cmd:%c,data_len=%d\n", cmd, data_len);
+        return;
+    }
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    if (type >= 0x80) {
+        link_write(type, data, data_len);            // 链路控制帧不占信用，直接发
+        xSemaphoreGive(tx_lock);
+        return;
+    }
+    for (int i = 0; i < txq_count;) {
+        if (supersedes(type, tx_slots[txq[i]].type)) {
+            tx_slots[txq[i]].len = 0xffff;
+            txq_remove(i);
+            superseded++;
+        } else {
+            i++;
+        }
+    }
+    int free_slot = -1;
+    uint32_t wait_start = millis();
+    for (;;) {
+        for (int i = 0; i < LINK_TXQ_SLOTS; i++) {
+            if (tx_slots[i].len == 0xffff) {
+                free_slot = i;
                 break;
             }
-            free(newdata);
         }
+        if (free_slot >= 0 || !is_stream(type) || millis() - wait_start > 2 * AR_LINK_ACK_TIMEOUT_MS) {
+            break;
+        }
+        xSemaphoreGive(tx_lock);                     // 等 ACK 把队列腾出来
+        vTaskDelay(pdMS_TO_TICKS(2));
+        xSemaphoreTake(tx_lock, portMAX_DELAY);
+    }
+    if (free_slot < 0) {
+        AR_STAT(link_stats.drops++);
+        xSemaphoreGive(tx_lock);
+        Serial.printf("发送队列满，丢弃: cmd:%c\n", cmd);
+        return;
+    }
+    tx_slot *slot = &tx_slots[free_slot];
+    slot->type = type;
+    slot->len = data_len;
+    slot->us = micros();
+    memcpy(slot->data, data, data_len);
+    txq[txq_count++] = free_slot;
+    AR_STAT(ar_link::stats_high(&link_stats.queue_high, txq_count));
+    txq_pump();
+    xSemaphoreGive(tx_lock);
+}
+
+//------------------------------ACK 与信用----------------------------------//
+static void link_reset_credits()
+{
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    credits = AR_LINK_CREDITS;
+    inflight = 0;
+    xSemaphoreGive(tx_lock);
 }
 
+static void link_on_ack(const uint8_t *ack)
+{
+    uint8_t seq = ack[0];
+    uint8_t flags = ack[1];
+    uint32_t queue_us = ar_link::get_u32(ack + 2);
+    uint32_t render_us = ar_link::get_u32(ack + 6);
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    uint32_t total_us = micros() - sent_us[seq];
+    AR_STAT(ar_link::stats_hist(link_stats.transit, total_us));
+    if (inflight > 0) {
+        inflight--;
+    }
+    if (credits < AR_LINK_CREDITS) {
+        credits++;
+    }
+    ack_wait_ms = millis();
+    txq_pump();
+    xSemaphoreGive(tx_lock);
+    if (flags & AR_LINK_ACK_DROPPED) {
+        Serial.printf("ack seq %u: C3 丢弃\n", seq);
+    } else {
+        LINK_LOG("ack seq %u: 端到端 %lu us (C3 排队 %lu us, 渲染 %lu us), 已作废 %lu 帧\n", seq,
+                 (unsigned long)total_us, (unsigned long)queue_us, (unsigned long)render_us,
+                 (unsigned long)superseded);
+    }
+}
 
-void my_uart_init(){
-    Serial1.begin(115200,SERIAL_8N1,UART_RX,UART_TX);
-    Serial1.onReceive(onDataReceived);
+// 有帧在途却长时间没有 ACK：帧丢了或者 C3 复位了，收回信用并重新协商
+static bool link_ack_timeout()
+{
+    bool timeout = false;
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    if (inflight > 0 && millis() - ack_wait_ms > AR_LINK_ACK_TIMEOUT_MS) {
+        Serial.printf("ack 超时，%d 帧在途\n", inflight);
+        credits = AR_LINK_CREDITS;
+        inflight = 0;
+        timeout = true;
+    }
+    xSemaphoreGive(tx_lock);
+    return timeout;
+}
+
+//------------------------------波特率协商----------------------------------//
+static bool link_wait(uint8_t type, uint32_t value, uint32_t timeout_ms, uint32_t *us)
+{
+    link_ctrl_evt evt;
+    uint32_t start = millis();
+    while (millis() - start < timeout_ms) {
+        if (xQueueReceive(ctrl_queue, &evt, pdMS_TO_TICKS(timeout_ms - (millis() - start) + 1)) &&
+            evt.type == type && evt.value == value) {
+            if (us) *us = evt.us;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void link_set_baud(uint32_t baud)
+{
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    uart_wait_tx_done(LINK_UART, pdMS_TO_TICKS(100));
+    uart_set_baudrate(LINK_UART, baud);
+    link_baud = baud;
+    xSemaphoreGive(tx_lock);
+}
+
+// 请求 C3 切换波特率，收到应答后本端也切换
+static bool link_switch(uint32_t baud)
+{
+    uint8_t v[4];
+    ar_link::put_u32(v, baud);
+    xQueueReset(ctrl_queue);
+    for (int retry = 0; retry < 3; retry++) {
+        my_tcp_send(AR_LINK_BAUD_REQ, (char *)v, sizeof(v));
+        if (link_wait(AR_LINK_BAUD_ACK, baud, 100, NULL)) {
+            link_set_baud(baud);
+            vTaskDelay(pdMS_TO_TICKS(5));            // 等 C3 切换完
+            return true;
+        }
+    }
+    return false;
+}
+
+// 本端退回默认波特率，并等 C3 试用期超时自己退回
+static void link_fallback()
+{
+    link_set_baud(AR_LINK_BAUD_DEFAULT);
+    vTaskDelay(pdMS_TO_TICKS(AR_LINK_PROBATION_MS + 50));
+    uart_flush_input(LINK_UART);
 }
 
-struct My_tcpdata *create_data(char cmd, char *data, int data_len)
+// 在当前波特率下发 LINK_PING_COUNT 个整页大小的 PING，统计每帧往返时间和吞吐
+static bool link_ping_test()
 {
-    struct My_tcpdata *tcpdata = (struct My_tcpdata*)malloc(sizeof(struct My_tcpdata));
-    tcpdata->cmd = cmd;
-    tcpdata->data = data;
-    tcpdata->data_len = data_len;
-    return tcpdata;
+    static uint8_t payload[LINK_PING_SIZE];
+    uint32_t total_us = 0, max_us = 0;
+    xQueueReset(ctrl_queue);
+    for (uint32_t i = 0; i < LINK_PING_COUNT; i++) {
+        ar_link::put_u32(payload, i);
+        uint32_t t0 = micros(), t1;
+        my_tcp_send(AR_LINK_PING, (char *)payload, sizeof(payload));
+        if (!link_wait(AR_LINK_PONG, i, 100, &t1)) {
+            Serial.printf("link %lu baud: ping %lu 超时\n", (unsigned long)link_baud, (unsigned long)i);
+            return false;
+        }
+        total_us += t1 - t0;
+        if (t1 - t0 > max_us) max_us = t1 - t0;
+    }
+    uint32_t bytes = 2 * LINK_PING_COUNT * (sizeof(payload) + AR_LINK_HEADER_MAX + AR_LINK_CRC_LEN);
+    Serial.printf("link %lu baud: 每帧往返 avg %lu us max %lu us, 吞吐 %lu B/s\n",
+                  (unsigned long)link_baud, (unsigned long)(total_us / LINK_PING_COUNT), (unsigned long)max_us,
+                  (unsigned long)((uint64_t)bytes * 1000000 / total_us));
+    return true;
 }
 
-void my_tcp_send(struct My_tcpdata *tcpdata)
+static void link_negotiate()
 {
-    char sendbuff[11];
-    sprintf(sendbuff, "%c%08d", tcpdata->cmd, tcpdata->data_len);
-    Serial1.write(sendbuff);
-    Serial1.write(tcpdata->data);
-    Serial.printf("发送成功:cmd:%c,data_len=%d ", tcpdata->cmd, tcpdata->data_len);
-    free(tcpdata);
+    static const uint32_t rates[] = AR_LINK_BAUD_RATES;
+    if (link_baud != AR_LINK_BAUD_DEFAULT) {
+        link_fallback();
+    }
+    if (!link_ping_test()) {
+        Serial.printf("link: C3 无应答，保持 %d baud\n", AR_LINK_BAUD_DEFAULT);
+        return;
+    }
+    uint32_t best = AR_LINK_BAUD_DEFAULT;
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (!ar_link::baud_supported(rates[i])) continue;
+        if (!link_switch(rates[i])) break;             // C3 不支持协商
+        if (link_ping_test()) {
+            if (best == AR_LINK_BAUD_DEFAULT) best = rates[i];
+            if (!LINK_BAUD_BENCH) break;
+        } else {
+            link_fallback();
+        }
+    }
+    if (best != link_baud) {
+        if (link_baud != AR_LINK_BAUD_DEFAULT) link_fallback();
+        if (best != AR_LINK_BAUD_DEFAULT && !link_switch(best)) best = AR_LINK_BAUD_DEFAULT;
+    }
+    Serial.printf("link: 使用 %lu baud\n", (unsigned long)link_baud);
 }
-void send_string(char cmd, char *str)
+
+static void link_task(void *arg)
 {
-    my_tcp_send(create_data(cmd, str, strlen(str)));
+    for (;;) {
+        xSemaphoreTake(tx_lock, portMAX_DELAY);
+        negotiating = true;
+        xSemaphoreGive(tx_lock);
+        link_negotiate();
+        xSemaphoreTake(tx_lock, portMAX_DELAY);
+        negotiating = false;
+        txq_pump();                                   // 协商期间排着的帧
+        xSemaphoreGive(tx_lock);
+        // C3 复位、链路出错或者 ACK 超时时重新协商
+        while (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) && !link_ack_timeout()) {
+        }
+    }
+}
+
+void my_uart_init(){
+    uart_config_t config = {};
+    config.baud_rate = AR_LINK_BAUD_DEFAULT;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+    uart_driver_install(LINK_UART, LINK_RX_BUF, LINK_TX_BUF, 20, &uart_queue, 0);
+    uart_param_config(LINK_UART, &config);
+    uart_set_pin(LINK_UART, UART_TX, UART_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_set_rx_timeout(LINK_UART, 2);                // 线上空闲 2 个字符就上报，不用等满阈值
+
+    for (int i = 0; i < LINK_TXQ_SLOTS; i++) {
+        tx_slots[i].len = 0xffff;
+    }
+    tx_lock = xSemaphoreCreateMutex();
+    ctrl_queue = xQueueCreate(8, sizeof(link_ctrl_evt));
+    xTaskCreate(link_task, "uart_link", 1024 * 3, NULL, 5, &link_task_handle);
+    xTaskCreate(uart_rx_task, "uart_rx", 1024 * 4, NULL, 12, NULL);
+}
+
+void send_string(char cmd, const char *str)
+{
+    my_tcp_send(cmd, str, strlen(str));
 }
 void send_hex(char cmd, char *buff, int len)
 {
-    my_tcp_send(create_data(cmd, buff, len));
+    my_tcp_send(cmd, buff, len);
 }
 
 
@@ -125,4 +520,127 @@ void send_bar(int num){
 }
 void send_bottom(char *str){
     send_string('h',str);
-}
\ No newline at end of file
+}
+void send_live_set(char *str){
+    send_string('j',str);
+}
+void send_live_append(char *str){
+    send_string('k',str);
+}
+
+//------------------------------屏幕状态帧----------------------------------//
+void screen_state_begin(screen_state *st){
+    st->len = 0;
+}
+void screen_state_add(screen_state *st, char field, const char *str){
+    screen_state_add_data(st, field, str, strlen(str));
+}
+void screen_state_add_data(screen_state *st, char field, const void *data, size_t n){
+    size_t len = ar_link::tlv_put(st->buf, st->len, sizeof(st->buf), field, data, n);
+    if (len == st->len) {
+        Serial.printf("屏幕状态帧放不下字段 %c\n", field);
+    }
+    st->len = len;
+}
+void screen_state_add_bar(screen_state *st, int num){
+    char str[12];
+    sprintf(str,"%d",num);
+    screen_state_add(st, 'i', str);
+}
+void send_screen_state(screen_state *st){
+    if (st->len > 0) {
+        send_hex(AR_LINK_SCREEN, (char *)st->buf, st->len);
+    }
+}
+
+//------------------------------图片----------------------------------//
+// 图片文件原样分段发给 C3，由 C3 边收边解码；x/y 是显示位置，JPEG/PNG 的 w/h 可以填 0
+void send_image(uint8_t fmt, int x, int y, int w, int h, const uint8_t *data, size_t len)
+{
+    uint8_t hdr[AR_LINK_IMG_HDR_LEN];
+    hdr[0] = fmt;
+    ar_link::put_u16(hdr + 1, x);
+    ar_link::put_u16(hdr + 3, y);
+    ar_link::put_u16(hdr + 5, w);
+    ar_link::put_u16(hdr + 7, h);
+    ar_link::put_u32(hdr + 9, len);
+    uint32_t t0 = millis();
+    my_tcp_send(AR_LINK_IMG_BEGIN, (char *)hdr, sizeof(hdr));
+    while (len > 0) {
+        size_t n = len < LINK_IMG_CHUNK ? len : LINK_IMG_CHUNK;
+        my_tcp_send(AR_LINK_IMG_DATA, (const char *)data, n);
+        data += n;
+        len -= n;
+    }
+    Serial.printf("图片发送 %lu ms\n", (unsigned long)(millis() - t0));
+}
+
+//------------------------------链路统计----------------------------------//
+// 给 BLE 诊断特征值读：本端统计加上 C3 上一次上报的统计和面板温控状态，同时请 C3 再报一次统计，下次读就是新的
+size_t my_uart_link_stats(char *out, size_t cap)
+{
+    const ar_link::ParserStats &ps = rx_parser.stats();
+    link_stats.version = sizeof(link_stats);
+    link_stats.crc_errors = ps.crc_errors;
+    link_stats.len_errors = ps.len_errors;
+    link_stats.resyncs = ps.resyncs;
+    link_stats.skipped = ps.skipped;
+    link_stats.superseded = superseded;
+    size_t n = ar_link::stats_format(link_stats, "S3", out, cap);
+    if (c3_stats_valid && n + 1 < cap) {
+        n += ar_link::stats_format(c3_stats, "C3", out + n, cap - n);
+    }
+    if (c3_thermal_valid && n + 1 < cap) {
+        int16_t t = (int16_t)ar_link::get_u16(c3_thermal);
+        char temp[12] = "?";
+        if (t != AR_THERMAL_NONE) {
+            snprintf(temp, sizeof(temp), "%d.%d", t / 10, abs(t % 10));
+        }
+        int r = snprintf(out + n, cap - n, "C3 panel %sC lum%u cur%u lvl%u\n", temp, ar_link::get_u16(c3_thermal + 2),
+                         c3_thermal[4], c3_thermal[5]);
+        n += r > 0 ? r : 0;
+        if (n >= cap) n = cap - 1;
+    }
+    my_tcp_send(AR_LINK_STATS_REQ, NULL, 0);
+    return n;
+}
+
+//------------------------------显示基准测试----------------------------------//
+// C3 跑一组固定场景（见 AR_light 的 my_bench.cpp），跑的那几秒不处理显示帧，期间别发别的
+void send_display_bench()
+{
+    c3_bench_mask = 0;
+    c3_bench_done = false;
+    my_tcp_send(AR_LINK_BENCH_REQ, NULL, 0);
+}
+
+// 结果齐了就按场景一行格式化（每帧平均，us），取走一次以后返回 0；还没跑完也返回 0
+size_t my_uart_bench_take(char *out, size_t cap)
+{
+    static const char *const names[AR_BENCH_SCENES] = AR_BENCH_NAMES;
+    if (!c3_bench_done || cap == 0) {
+        return 0;
+    }
+    c3_bench_done = false;
+    size_t n = 0;
+    out[0] = 0;
+    for (int i = 0; i < AR_BENCH_SCENES && n + 1 < cap; i++) {
+        if (!(c3_bench_mask & (1 << i))) {
+            continue;
+        }
+        const uint8_t *b = c3_bench[i];
+        uint32_t frames = ar_link::get_u16(b + 1);
+        uint32_t total = ar_link::get_u32(b + 3);
+        uint32_t f = frames ? frames : 1;
+        uint32_t fps10 = total ? (uint32_t)((uint64_t)frames * 10000000 / total) : 0;
+        int r = snprintf(out + n, cap - n, "C3 bench %s %luf %lu.%lufps render%lu pack%lu spi%lu sync%lu us/f %luB/f\n", names[i],
+                         (unsigned long)frames, (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10),
+                         (unsigned long)(ar_link::get_u32(b + 7) / f), (unsigned long)(ar_link::get_u32(b + 11) / f),
+                         (unsigned long)(ar_link::get_u32(b + 15) / f), (unsigned long)(ar_link::get_u32(b + 19) / f),
+                         (unsigned long)(ar_link::get_u32(b + 23) / f));
+        n += r > 0 ? r : 0;
+        if (n >= cap) n = cap - 1;
+    }
+    return n;
+}
+
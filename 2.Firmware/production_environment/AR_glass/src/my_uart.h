@@ -3,25 +3,28 @@
 
 #define UART_RX 42
 #define UART_TX 41
-#include "Arduino.h"
 
-struct My_tcpdata
-{
-    char cmd;
-    int data_len;
-    char* data;
-};
+#define LINK_UART       UART_NUM_1
+#define LINK_RX_BUF     4096      // 驱动接收环形缓冲
+#define LINK_TX_BUF     4096      // 驱动发送环形缓冲，发送时只拷贝不等待
+#define LINK_PING_SIZE  370       // 测速用的 PING 大小，约等于一整页中文
+#define LINK_PING_COUNT 8
+#define LINK_TXQ_SLOTS  8         // 等信用的显示帧队列
+#define LINK_IMG_CHUNK  1000      // 图片按这么大分段
+#define LINK_BAUD_BENCH 0         // 1: 每次协商把所有波特率都测一遍并打印，0: 找到能用的最高档就停
+#define LINK_LOG_FRAMES 0         // 1: 每帧打印收发内容和 ACK，调协议时打开；平时关掉，图片分段和 ACK 会刷屏
+#define LINK_LOG(...)   do { if (LINK_LOG_FRAMES) Serial.printf(__VA_ARGS__); } while (0)
+#include "Arduino.h"
+#include "ar_link.h"
 
 void my_uart_init();
-void send_string(char cmd,char *str);
+void send_string(char cmd,const char *str);
 void send_hex(char cmd,char *buff,int len);
 
 
 
 //-----------------自定义通讯协议---------------------------//
-//cmd            1 byte          命令位
-//data_len       8 byte          长度位
-//data           data_len byte   数据位  
+//帧格式见 shared/ar_link/ar_link.h：同步字 + 命令 + 序号 + 长度 + 数据 + CRC16
 //---------------------命令表------------------------------//        
 
 void send_content(char *str);
@@ -33,4 +36,23 @@ void send_ble(bool isopen);
 void send_battery(int num);
 void send_bar(int num);
 void send_bottom(char *str);
+void send_live_set(char *str);
+void send_live_append(char *str);
+
+// 屏幕状态帧 'l'：翻页时文件名、内容、进度条、页码拼成一帧，C3 在同一次刷新里全部应用
+struct screen_state
+{
+    uint8_t buf[AR_LINK_MAX_PAYLOAD];
+    size_t len;
+};
+void screen_state_begin(screen_state *st);
+void screen_state_add(screen_state *st, char field, const char *str);   // field 用单字段命令的字母
+void screen_state_add_data(screen_state *st, char field, const void *data, size_t n);   // 二进制字段，如显示列表 'o'
+void screen_state_add_bar(screen_state *st, int num);
+void send_screen_state(screen_state *st);
+
+void send_image(uint8_t fmt, int x, int y, int w, int h, const uint8_t *data, size_t len);
+size_t my_uart_link_stats(char *out, size_t cap);
+void send_display_bench();                          // 请 C3 跑一次显示基准测试
+size_t my_uart_bench_take(char *out, size_t cap);   // 结果齐了返回格式化好的文本长度，否则 0
 #endif
@@ -0,0 +1,59 @@
+/*
+ * @Description: 主机单元测试用的 Arduino.h 桩，只提供被测代码用到的那几个接口
+ *
+ *   Serial       printf/print/println，默认不输出，host_serial_verbose = true 时打到 stdout
+ *   millis/micros  从进程启动开始的真实时间
+ *   ESP.getFreeHeap()  返回 host_free_heap，测试可以改它模拟协议栈占用
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <chrono>
+
+inline bool host_serial_verbose = false;
+inline uint32_t host_free_heap = 300000;
+
+inline uint64_t host_now_us()
+{
+    static const auto t0 = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+inline unsigned long millis() { return (unsigned long)(host_now_us() / 1000); }
+inline unsigned long micros() { return (unsigned long)host_now_us(); }
+
+class HostSerial
+{
+ public:
+  void begin(unsigned long) {}
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    if (!host_serial_verbose) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+  }
+  void print(const char *s) { if (host_serial_verbose) fputs(s, stdout); }
+  void println(const char *s) { if (host_serial_verbose) puts(s); }
+};
+inline HostSerial Serial;
+
+class HostEsp
+{
+ public:
+  uint32_t getFreeHeap() { return host_free_heap; }
+};
+inline HostEsp ESP;
+
+#define ESP_LOGI(tag, ...) do { } while (0)
+#define ESP_LOGE(tag, ...) do { } while (0)
+
+#endif
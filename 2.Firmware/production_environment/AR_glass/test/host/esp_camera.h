@@ -0,0 +1,2 @@
+// 主机测试用的空桩：my_camera.h 只要 queue_data_t，摄像头驱动本身不参与测试
+#pragma once
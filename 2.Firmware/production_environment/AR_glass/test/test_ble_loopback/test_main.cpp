@@ -0,0 +1,213 @@
+// GATT 协议层（my_ble.cpp）通过内存回环传输层在主机上跑：测试扮演手机写特征值、读特征值、收通知，
+// 协议层调用的 SD、音频、串口等函数换成下面的桩，记下调用方便断言。
+#include <unity.h>
+#include <string>
+#include <vector>
+
+#include "../../src/my_ble_transport.cpp"
+#include "../../src/my_ble_loopback.cpp"
+#include "../../src/my_ble.cpp"
+
+//-----------------------------桩-----------------------------//
+static std::string sd_path;
+static std::string sd_data;
+static int sd_ends = 0;
+static std::vector<int> ble_states;
+static std::string live_text;
+static int volume = 0;
+queue_data_t my_image = {0, NULL};
+
+void start_write(const char *path) { sd_path = path; sd_data.clear(); }
+void update_write(uint8_t *data, size_t len) { sd_data.append((const char *)data, len); }
+void end_write() { sd_ends++; }
+void send_ble(bool isopen) { ble_states.push_back(isopen); }
+void live_text_push(const uint8_t *data, size_t len) { live_text.append((const char *)data, len); }
+void vol_up() { volume++; }
+void vol_down() { volume--; }
+int my_driver_get_battery_percent() { return 87; }
+size_t my_uart_link_stats(char *out, size_t cap) { return snprintf(out, cap, "S3 crc0\n"); }
+
+//-----------------------------工具-----------------------------//
+static BleLoopback *phone;
+
+static void write_str(ble_char_id id, const char *s)
+{
+    phone->write(id, (const uint8_t *)s, strlen(s));
+}
+
+static std::string read_str(ble_char_id id)
+{
+    std::vector<uint8_t> v = phone->read(id);
+    return std::string(v.begin(), v.end());
+}
+
+void setUp(void)
+{
+    if (phone->connected()) {
+        phone->disconnect();
+    }
+    BleLoopback::Notification n;
+    while (phone->pop_notification(&n)) {
+    }
+    ble_states.clear();
+    BLEServerDemo::nowthing = 0;
+}
+
+void tearDown(void) {}
+
+//-----------------------------用例-----------------------------//
+static void test_service_table(void)
+{
+    // 每个特征值都属于表里的某个服务，UUID 不重复
+    for (int i = 0; i < BLE_CHAR_COUNT; i++) {
+        bool found = false;
+        for (int s = 0; s < ble_service_count; s++) {
+            found |= ble_char_table[i].service == ble_service_table[s];
+        }
+        TEST_ASSERT_TRUE(found);
+        for (int j = i + 1; j < BLE_CHAR_COUNT; j++) {
+            TEST_ASSERT_TRUE(ble_char_table[i].uuid != ble_char_table[j].uuid);
+        }
+    }
+    char uuid[37];
+    ble_uuid_str(0x0303, uuid);
+    TEST_ASSERT_EQUAL_STRING("aabb0303-0000-1000-8000-00805f9b34fb", uuid);
+}
+
+static void test_connect_updates_display(void)
+{
+    phone->connect();
+    TEST_ASSERT_TRUE(phone->connected());
+    phone->disconnect();
+    TEST_ASSERT_EQUAL(2, ble_states.size());
+    TEST_ASSERT_EQUAL(1, ble_states[0]);
+    TEST_ASSERT_EQUAL(0, ble_states[1]);
+}
+
+static void test_notify_needs_connection(void)
+{
+    BleLoopback::Notification n;
+    BLEServerDemo::send_my_data("dropped");
+    TEST_ASSERT_FALSE(phone->pop_notification(&n));
+    phone->connect();
+    BLEServerDemo::send_my_data("hello");
+    TEST_ASSERT_TRUE(phone->pop_notification(&n));
+    TEST_ASSERT_EQUAL(BLE_CHAR_NOTIFY, n.id);
+    TEST_ASSERT_EQUAL_STRING("hello", std::string(n.value.begin(), n.value.end()).c_str());
+}
+
+static void test_ctrl_page_commands(void)
+{
+    phone->connect();
+    write_str(BLE_CHAR_FILE_NAME, "/sdcard/txt/book.txt");
+    write_str(BLE_CHAR_CTRL, "display_txt");
+    TEST_ASSERT_EQUAL(1, BLEServerDemo::nowthing);
+    TEST_ASSERT_EQUAL(1, BLEServerDemo::nowmode);
+    TEST_ASSERT_EQUAL(0, BLEServerDemo::nowpage);
+    TEST_ASSERT_EQUAL_STRING("/sdcard/txt/book.txt", BLEServerDemo::nowname);
+
+    BLEServerDemo::nowthing = 0;
+    write_str(BLE_CHAR_CTRL, "next_page");
+    TEST_ASSERT_EQUAL(1, BLEServerDemo::nowthing);
+    TEST_ASSERT_EQUAL(1, BLEServerDemo::nowpage);
+    write_str(BLE_CHAR_CTRL, "pre_page");
+    write_str(BLE_CHAR_CTRL, "pre_page");
+    TEST_ASSERT_EQUAL(0, BLEServerDemo::nowpage);    // 不会翻到负数
+
+    write_str(BLE_CHAR_CTRL, "display_json");
+    TEST_ASSERT_EQUAL(2, BLEServerDemo::nowthing);
+    write_str(BLE_CHAR_CTRL, "display_bench");
+    TEST_ASSERT_EQUAL(8, BLEServerDemo::nowthing);
+
+    int v = volume;
+    write_str(BLE_CHAR_CTRL, "vol_up");
+    TEST_ASSERT_EQUAL(v + 1, volume);
+    write_str(BLE_CHAR_CTRL, "display_tx");           // 前缀不算
+    TEST_ASSERT_EQUAL(8, BLEServerDemo::nowthing);
+}
+
+static void test_file_transfer(void)
+{
+    write_str(BLE_CHAR_FILE_NAME, "/sdcard/json/a.json");
+    write_str(BLE_CHAR_FILE_DATA, "{\"a\":");
+    write_str(BLE_CHAR_FILE_CMD, "start");
+    write_str(BLE_CHAR_FILE_DATA, "1}");
+    write_str(BLE_CHAR_FILE_CMD, "update");
+    int ends = sd_ends;
+    write_str(BLE_CHAR_FILE_CMD, "end");
+    TEST_ASSERT_EQUAL_STRING("/sdcard/json/a.json", sd_path.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1}", sd_data.c_str());
+    TEST_ASSERT_EQUAL(ends + 1, sd_ends);
+}
+
+static void test_long_name_rejected(void)
+{
+    // 放不进 nowname 的文件名整个丢掉，还用上一个
+    write_str(BLE_CHAR_FILE_NAME, "/sdcard/mp3/a.mp3");
+    std::string name(sizeof(BLEServerDemo::nowname), 'x');
+    write_str(BLE_CHAR_FILE_NAME, name.c_str());
+    write_str(BLE_CHAR_CTRL, "play_mp3");
+    TEST_ASSERT_EQUAL_STRING("/sdcard/mp3/a.mp3", BLEServerDemo::nowname);
+    name.resize(sizeof(BLEServerDemo::nowname) - 1);
+    write_str(BLE_CHAR_FILE_NAME, name.c_str());
+    write_str(BLE_CHAR_CTRL, "play_mp3");
+    TEST_ASSERT_EQUAL_STRING(name.c_str(), BLEServerDemo::nowname);
+}
+
+static void test_image_chunks(void)
+{
+    static uint8_t jpeg[1000];
+    for (size_t i = 0; i < sizeof(jpeg); i++) {
+        jpeg[i] = (uint8_t)(i * 7);
+    }
+    my_image.buf = jpeg;
+    my_image.len = sizeof(jpeg);
+    phone->connect();
+    write_str(BLE_CHAR_IMAGE_CMD, "takeimage");
+    std::string len = read_str(BLE_CHAR_IMAGE_LEN);
+    TEST_ASSERT_EQUAL(sizeof(int), len.size());
+    int n;
+    memcpy(&n, len.data(), sizeof(n));
+    TEST_ASSERT_EQUAL(1000, n);
+
+    std::vector<uint8_t> got;
+    BleLoopback::Notification note;
+    for (int i = 0; i < 3; i++) {
+        write_str(BLE_CHAR_IMAGE_CMD, "getimage");
+        TEST_ASSERT_TRUE(phone->pop_notification(&note));
+        TEST_ASSERT_EQUAL(BLE_CHAR_IMAGE_DATA, note.id);
+        TEST_ASSERT_EQUAL(i < 2 ? chunk_num : 1000 - 2 * chunk_num, note.value.size());
+        got.insert(got.end(), note.value.begin(), note.value.end());
+    }
+    TEST_ASSERT_TRUE(phone->pop_notification(&note));
+    TEST_ASSERT_EQUAL(BLE_CHAR_NOTIFY, note.id);
+    TEST_ASSERT_EQUAL_STRING("image_end", std::string(note.value.begin(), note.value.end()).c_str());
+    TEST_ASSERT_EQUAL_MEMORY(jpeg, got.data(), sizeof(jpeg));
+    TEST_ASSERT_FALSE(phone->pop_notification(&note));
+}
+
+static void test_reads_and_live_text(void)
+{
+    TEST_ASSERT_EQUAL_STRING("87", read_str(BLE_CHAR_BATTERY).c_str());
+    TEST_ASSERT_EQUAL_STRING("S3 crc0\n", read_str(BLE_CHAR_DIAG).c_str());
+    TEST_ASSERT_EQUAL(0, read_str(BLE_CHAR_CTRL).size());   // 只写的特征值读出来是空的
+    write_str(BLE_CHAR_LIVE, "实时");
+    write_str(BLE_CHAR_LIVE, "字幕");
+    TEST_ASSERT_EQUAL_STRING("实时字幕", live_text.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    BLEServerDemo::my_ble_init();
+    phone = ble_loopback();
+    UNITY_BEGIN();
+    RUN_TEST(test_service_table);
+    RUN_TEST(test_connect_updates_display);
+    RUN_TEST(test_notify_needs_connection);
+    RUN_TEST(test_ctrl_page_commands);
+    RUN_TEST(test_file_transfer);
+    RUN_TEST(test_long_name_rejected);
+    RUN_TEST(test_image_chunks);
+    RUN_TEST(test_reads_and_live_text);
+    return UNITY_END();
+}
@@ -12,8 +12,167 @@
 #include <esp32-hal-gpio.h>
 #include <Arduino.h>
 #include <Wire.h>
+#include "driver/spi_master.h"
+#include "hal/gpio_ll.h"
+#include "string.h"
 // 引脚定义
 
+#if PANEL_USE_DMA
+static spi_device_handle_t spiDev = NULL;           // 命令、寄存器、读数据和不排队的写缓存，CS 由 set_spi_cs_pin 控制
+static spi_device_handle_t dmaDev = NULL;           // 排队写缓存：命令、地址、dummy、像素一次传输，CS 在中断里拉
+
+// 排队写缓存用的槽，按顺序轮流用；spi_master 对同一个设备按排队顺序返回结果
+struct dma_slot
+{
+    spi_transaction_ext_t t;
+    void (*done)(void *);                           // 这次传输发完后在中断里调用
+    void *arg;
+    u8 buf[PANEL_DMA_ROW + 1];
+};
+static DMA_ATTR dma_slot dmaSlots[PANEL_DMA_QUEUE];
+static u16 dmaHead = 0;                             // 下一个要用的槽
+static u16 dmaBusy = 0;                             // 排着队还没取回结果的个数
+static void (*dmaNextDone)(void *) = NULL;          // spi_dma_on_done 设的，挂到下一次排队的传输上
+static void *dmaNextArg = NULL;
+static u32 dmaStallUs = 0;                          // 槽用完了等 DMA 的时间
+static u8 dmaOk = 0;                                // spi_master 初始化成功；失败时退回 Arduino SPI
+#endif
+
+#if PANEL_USE_DMA
+// 两个回调都在 SPI 中断里跑，只能调 IRAM 里的代码：CS 直接写寄存器（gpio_set_level 默认在 flash），
+// spi_dma_on_done 设的回调也要是 IRAM_ATTR
+static void IRAM_ATTR dma_pre_cb(spi_transaction_t *t)
+{
+    gpio_ll_set_level(&GPIO, SPI_CS, 0);
+}
+
+static void IRAM_ATTR dma_post_cb(spi_transaction_t *t)
+{
+    dma_slot *s = (dma_slot *)t;
+
+    gpio_ll_set_level(&GPIO, SPI_CS, 1);
+    if (s->done)
+    {
+        s->done(s->arg);
+    }
+}
+#endif
+
+/**
+ * @description: Initialize the SPI bus of the panel
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ * PANEL_USE_DMA=1 时 SPI2 由 spi_master 驱动，引脚和 Arduino SPI 一样只有 CLK、MOSI、CS，单线 PANEL_SPI_HZ。
+ * spiDev 的 CS 不由驱动接管，仍由 set_spi_cs_pin 控制，一条命令可以拆成几次传输；
+ * dmaDev 给 spi_dma_* 排队写缓存用，每次传输是一条完整的命令，像素走 DMA，CS 在传输前后的中断回调里拉。
+ * 总线或设备初始化失败时打印错误、释放已经挂上的，退回 Arduino SPI，spi_dma_ok() 返回0。
+ * PANEL_USE_DMA=0 时还是原来的 Arduino SPI 单线 8MHz。
+ */
+#if PANEL_USE_DMA
+static esp_err_t spi_dma_init(void)
+{
+    spi_bus_config_t bus = {};
+    spi_device_interface_config_t dev = {};
+    esp_err_t err;
+
+    bus.mosi_io_num = SPI_MOSI;
+    bus.miso_io_num = -1;           // 和 Arduino SPI.begin 一样不接 MISO
+    bus.sclk_io_num = SPI_CLK;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = PANEL_DMA_CHUNK;
+    bus.flags = SPICOMMON_BUSFLAG_MASTER;
+    err = spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK)
+    {
+        Serial.printf("面板 SPI 总线初始化失败: %s\n", esp_err_to_name(err));
+        return err;
+    }
+
+    dev.mode = 0;
+    dev.clock_speed_hz = PANEL_SPI_HZ;
+    dev.spics_io_num = -1;
+    dev.queue_size = 1;
+    err = spi_bus_add_device(SPI2_HOST, &dev, &spiDev);
+
+    dev.command_bits = 8;
+    dev.address_bits = 24;
+    dev.dummy_bits = 8;
+    dev.flags = SPI_DEVICE_HALFDUPLEX;
+    dev.queue_size = PANEL_DMA_QUEUE;
+    dev.pre_cb = dma_pre_cb;
+    dev.post_cb = dma_post_cb;
+    if (err == ESP_OK)
+    {
+        err = spi_bus_add_device(SPI2_HOST, &dev, &dmaDev);
+    }
+
+    if (err != ESP_OK)      // 挂上的设备和总线都放掉，Arduino SPI 还要用 SPI2
+    {
+        Serial.printf("面板 SPI 设备添加失败: %s\n", esp_err_to_name(err));
+        if (spiDev != NULL)
+        {
+            spi_bus_remove_device(spiDev);
+            spiDev = NULL;
+        }
+        dmaDev = NULL;
+        spi_bus_free(SPI2_HOST);
+    }
+    return err;
+}
+
+// spiDev 上同步发一段，长的按 PANEL_DMA_CHUNK 分几次传输，CS 由调用者拉
+static void spi_tx_buf(const u8 *pBuf, u32 len)
+{
+    spi_transaction_t t = {};
+    u32 n;
+
+    while (len > 0)
+    {
+        n = len < PANEL_DMA_CHUNK ? len : PANEL_DMA_CHUNK;
+        t.length = n * 8;
+        t.tx_buffer = pBuf;
+        spi_device_polling_transmit(spiDev, &t);
+        pBuf += n;
+        len -= n;
+    }
+}
+#endif
+
+void spi_init(void)
+{
+#if PANEL_USE_DMA
+    dmaOk = spi_dma_init() == ESP_OK;
+    if (!dmaOk)
+    {
+        Serial.println("面板退回 Arduino SPI");
+        SPI.begin(SPI_CLK, -1, SPI_MOSI, SPI_CS);
+        SPI.beginTransaction(SPISettings(PANEL_SPI_HZ, MSBFIRST, SPI_MODE0));
+    }
+#else
+    SPI.begin(SPI_CLK, -1, SPI_MOSI, SPI_CS);
+    SPI.beginTransaction(SPISettings(PANEL_SPI_HZ, MSBFIRST, SPI_MODE0));
+#endif
+    pinMode(SPI_CS, OUTPUT);
+    digitalWrite(SPI_CS, HIGH);
+}
+
+/**
+ * @description: Check whether the panel is driven by spi_master
+ * @paran:
+ * @return {u8}：1：queued DMA writes are available，0：Arduino SPI
+ * @author: lmx
+ * PANEL_USE_DMA=0 或者 spi_init 退回 Arduino SPI 时为0，这时 spi_dma_* 都是发完才返回。
+ */
+u8 spi_dma_ok(void)
+{
+#if PANEL_USE_DMA
+    return dmaOk;
+#else
+    return 0;
+#endif
+}
 
 /**
  * @description: Delay N us
@@ -40,6 +199,17 @@ void delay_ms(u32 val)
     delay_us(val * 1000);
 }
 
+/**
+ * @description: Get the time since boot
+ * @paran:
+ * @return {u32}：time，unit：us（wraps around after about 71 minutes）
+ * @author: lmx
+ */
+u32 get_time_us(void)
+{
+    return micros();
+}
+
 /**
  * @description: Set spi_cs pin status
  * @paran:
@@ -51,14 +221,17 @@ void set_spi_cs_pin(u8 val)
 {
     // 测试添加
     //digitalWrite(5,val);
+#if PANEL_USE_DMA
+    if (val == SET_LOW)
+    {
+        spi_dma_wait(); // 排着队的传输会在中断里拉 CS，先等它们发完
+    }
+#endif
     digitalWrite(SPI_CS,val);
     // io.digitalWrite(C1_PIN, val);
     
 }
 
-//测试添加
-//配置QSPI
-//QSPI Qspi1 = QSPI(TFT_CLK, TFT_D0, TFT_D1, TFT_D2, TFT_D3, TFT_CS0);
 /**
  * @description: Send a byte of data
  * @paran:
@@ -68,6 +241,18 @@ void set_spi_cs_pin(u8 val)
  */
 void spi_tx_byte(u8 param)
 {
+#if PANEL_USE_DMA
+    if (dmaOk)
+    {
+        spi_transaction_t t = {};
+
+        t.flags = SPI_TRANS_USE_TXDATA;
+        t.length = 8;
+        t.tx_data[0] = param;
+        spi_device_polling_transmit(spiDev, &t);
+        return;
+    }
+#endif
     // 测试添加
     // 使用SPI设备发送数据
     //SPI.transfer(param);
@@ -83,12 +268,61 @@ void spi_tx_byte(u8 param)
  */
 u8 spi_rx_byte(void)
 {
+#if PANEL_USE_DMA
+    if (dmaOk)
+    {
+        spi_transaction_t t = {};
+
+        t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+        t.length = 8;
+        spi_device_polling_transmit(spiDev, &t);
+        return t.rx_data[0];
+    }
+#endif
     // 测试添加
     uint8_t data = SPI.transfer(0x00); // 发送一个空字节来接收数据
     //SPI.endTransaction();
     return data;
 }
 
+/**
+ * @description: Receive multiple bytes data
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ * @param {u8} *pBuf：Pointer to receive data
+ * @param {u32} len：Length of received data
+ */
+void spi_rx_bytes(u8 *pBuf, u32 len)
+{
+#if PANEL_USE_DMA
+    if (dmaOk)
+    {
+        spi_transaction_t t = {};
+        u32 n;
+
+        while (len > 0)         // 一段一次传输，不再一个字节一次
+        {
+            n = len < PANEL_DMA_CHUNK ? len : PANEL_DMA_CHUNK;
+            t.length = n * 8;
+            t.rxlength = n * 8;
+            t.tx_buffer = NULL;
+            t.rx_buffer = pBuf;
+            spi_device_polling_transmit(spiDev, &t);
+            pBuf += n;
+            len -= n;
+        }
+        return;
+    }
+#endif
+    u32 i;
+
+    for (i = 0; i < len; i++)
+    {
+        pBuf[i] = spi_rx_byte();
+    }
+}
+
 /**
  * @description: Write a byte of data
  * @paran:
@@ -156,15 +390,9 @@ void spi_wr_bytes(u8 cmd, u8 *pBuf, u32 len)
  */
 void spi_rd_bytes(u8 cmd, u8 *pBuf, u32 len)
 {
-    u32 i;
-
     set_spi_cs_pin(SET_LOW);
     spi_tx_byte(cmd);
-    for (i = 0; i < len; i++)
-    {
-        pBuf[i] = spi_rx_byte();
-    }
-
+    spi_rx_bytes(pBuf, len);
     set_spi_cs_pin(SET_HIGH);
 }
 
@@ -182,7 +410,6 @@ void spi_rd_bytes(u8 cmd, u8 *pBuf, u32 len)
  */
 void spi_rd_cache(u16 col, u16 row, u8 *pBuf, u32 len)
 {
-    u32 i;
     u32 addr;
 
     addr = ((row & 0x1ff) << 10) | (col & 0x3ff);
@@ -192,10 +419,7 @@ void spi_rd_cache(u16 col, u16 row, u8 *pBuf, u32 len)
     spi_tx_byte((u8)(addr >> 8));  // Addr
     spi_tx_byte((u8)(addr));       // Addr
     spi_tx_byte(0xff);             // Dummy
-    for (i = 0; i < len; i++)      // Pixel data
-    {
-        pBuf[i] = spi_rx_byte();
-    }
+    spi_rx_bytes(pBuf, len);       // Pixel data
     set_spi_cs_pin(SET_HIGH);
 }
 
@@ -241,42 +465,271 @@ void spi_rd_cache(u16 col, u16 row, u8 *pBuf, u32 len)
 // }
 void spi_wr_cache(u16 col, u16 row, u8 *pBuf, u32 len)
 {
-    u8 tmpData;
+    spi_wr_cache_end(col, row, pBuf, len, 0);
+}
+
+/**
+ * @description: Write data to the cache in the panel, with the gray of the end pixel
+ * @paran: Same as spi_wr_cache
+ * @return {*}
+ * @author: lmx
+ * @param {u8} endPixel：The last byte of the transfer, endPixel gray << 4 | 4bit dummy
+ *  写入会把 pBuf 后面紧跟的一个像素（col + len*2）也改写成 endPixel 里偶数列那半个字节
+ *  （哪半个见 pixel_pack.h 的 PIXEL_EVEN_HIGH），调用者需要保留那个像素时，用 pixel_pair 把它原来的灰度放在这里。
+ */
+void spi_wr_cache_end(u16 col, u16 row, u8 *pBuf, u32 len, u8 endPixel)
+{
     u32 addr;
-    u16 eCol;
-    u16 eRow;
 
-    eCol = col + (len * 2) % 640;
-    eRow = row + (len * 2) / 640;
     addr = ((row & 0x1ff) << 10) | (col & 0x3ff);
     set_spi_cs_pin(SET_LOW);
+#if PANEL_USE_DMA
+    if (dmaOk)
+    {
+        u8 d[] = {SPI_WR_CACHE, (u8)(addr >> 16), (u8)(addr >> 8), (u8)addr, 0xff};
+
+        spi_tx_buf(d, 5);
+        spi_tx_buf(pBuf, len);
+        spi_tx_byte(endPixel);
+        set_spi_cs_pin(SET_HIGH);
+        return;
+    }
+#endif
     uint8_t d[]={SPI_WR_CACHE,(addr >> 16),(addr >> 8),(addr),0xff};
     SPI.writeBytes(d,5);
     SPI.writeBytes(pBuf,len);
-    spi_tx_byte(tmpData); // Write endPiexl gray and 4bit dummy data （Dummy data can be any value）
+    spi_tx_byte(endPixel); // Write endPiexl gray and 4bit dummy data （Dummy data can be any value）
     set_spi_cs_pin(SET_HIGH);
 }
+#if PANEL_USE_DMA
 /**
- * @description: Read the data of the temperature sensor inside the panel
+ * @description: Get a free slot for a queued transaction
+ * @paran:
+ * @return {dma_slot *}
+ * @author: lmx
+ * 槽都在队列里时等最早的一个发完；取到的槽已清零，并带上 spi_dma_on_done 设的回调。
+ */
+static dma_slot *dma_slot_get(void)
+{
+    spi_transaction_t *r;
+    dma_slot *s;
+    u32 t0;
+
+    if (dmaBusy == PANEL_DMA_QUEUE)
+    {
+        t0 = get_time_us();
+        spi_device_get_trans_result(dmaDev, &r, portMAX_DELAY);
+        dmaBusy--;
+        dmaStallUs += get_time_us() - t0;
+    }
+    s = &dmaSlots[dmaHead];
+    dmaHead = (dmaHead + 1) % PANEL_DMA_QUEUE;
+    memset(&s->t, 0, sizeof(s->t));
+    s->done = dmaNextDone;
+    s->arg = dmaNextArg;
+    dmaNextDone = NULL;
+    dmaNextArg = NULL;
+    return s;
+}
+
+// 退回 Arduino SPI 时没有队列，同步发完后在这里调用 spi_dma_on_done 设的回调
+static void dma_sync_done(void)
+{
+    void (*done)(void *) = dmaNextDone;
+
+    dmaNextDone = NULL;
+    if (done)
+    {
+        done(dmaNextArg);
+    }
+    dmaNextArg = NULL;
+}
+
+static void dma_slot_queue(dma_slot *s)
+{
+    spi_device_queue_trans(dmaDev, &s->t.base, portMAX_DELAY);
+    dmaBusy++;
+}
+
+/**
+ * @description: Queue a write to the cache in the panel
+ * @paran: Same as spi_wr_cache_end, but returns once the data is copied and queued
+ * @return {*}
+ * @author: lmx
+ * 数据拷进槽里，调用者的缓冲马上就可以再用；超过 PANEL_DMA_ROW 的或者退回了 Arduino SPI 的同步写。
+ */
+void spi_dma_wr_cache(u16 col, u16 row, u8 *pBuf, u32 len, u8 endPixel)
+{
+    dma_slot *s;
+
+    if (!dmaOk)
+    {
+        spi_wr_cache_end(col, row, pBuf, len, endPixel);
+        dma_sync_done();
+        return;
+    }
+    if (len > PANEL_DMA_ROW)
+    {
+        spi_wr_cache_end(col, row, pBuf, len, endPixel);    // 先等队列发完，顺序不乱
+        dma_sync_done();
+        return;
+    }
+    s = dma_slot_get();
+    memcpy(s->buf, pBuf, len);
+    s->buf[len] = endPixel;
+    s->t.base.cmd = SPI_WR_CACHE;
+    s->t.base.addr = ((row & 0x1ff) << 10) | (col & 0x3ff);
+    s->t.base.length = (len + 1) * 8;
+    s->t.base.tx_buffer = s->buf;
+    dma_slot_queue(s);
+}
+
+/**
+ * @description: Queue a command without parameters
  * @paran:
  * @return {*}
  * @author: lmx
- * @param {u8} sensorId：Temperature sensor ID（Range：0~3）
- * @param {u8} *pBuf：Data buf
- * @param {u16} len of pbuf(More than 2000 recommended)
+ * @param {u8} cmd：SPI instruction of JBD013VGA panel
  */
-void spi_rd_temperature_sensor(u8 sensorId, u8 *pBuf, u16 len)
+void spi_dma_cmd(u8 cmd)
+{
+    dma_slot *s;
+
+    if (!dmaOk)
+    {
+        spi_wr_byte(cmd);
+        dma_sync_done();
+        return;
+    }
+    s = dma_slot_get();
+    s->t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;   // 只有 8 位命令
+    s->t.base.cmd = cmd;
+    dma_slot_queue(s);
+}
+
+/**
+ * @description: Set the callback of the next queued transaction
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ * @param {void (*)(void *)} done：Called in the SPI interrupt after the transaction has been sent（in the caller when spi_init fell back to Arduino SPI）, must be IRAM_ATTR
+ * @param {void *} arg：Argument of done
+ */
+void spi_dma_on_done(void (*done)(void *), void *arg)
+{
+    dmaNextDone = done;
+    dmaNextArg = arg;
+}
+
+/**
+ * @description: Get and clear the time spent waiting for a free slot
+ * @paran:
+ * @return {u32}：time，unit：us
+ * @author: lmx
+ */
+u32 spi_dma_stall_us(void)
+{
+    u32 us = dmaStallUs;
+
+    dmaStallUs = 0;
+    return us;
+}
+#endif
+
+/**
+ * @description: Wait until all queued transactions have been sent
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ */
+void spi_dma_wait(void)
+{
+#if PANEL_USE_DMA
+    spi_transaction_t *r;
+
+    while (dmaBusy > 0)
+    {
+        spi_device_get_trans_result(dmaDev, &r, portMAX_DELAY);
+        dmaBusy--;
+    }
+#endif
+}
+
+/**
+ * @description: Check whether all queued transactions have been sent, without waiting
+ * @paran:
+ * @return {u8}：1：nothing left in the queue，0：still sending
+ * @author: lmx
+ * 发完的顺手取回结果；返回1时下一次set_spi_cs_pin(SET_LOW)不会等DMA。
+ */
+u8 spi_dma_idle(void)
 {
-    u16 i;
+#if PANEL_USE_DMA
+    spi_transaction_t *r;
+
+    while (dmaBusy > 0 && spi_device_get_trans_result(dmaDev, &r, 0) == ESP_OK)
+    {
+        dmaBusy--;
+    }
+    return dmaBusy == 0;
+#else
+    return 1;
+#endif
+}
 
+/**
+ * @description: Start reading the temperature sensor inside the panel
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ * @param {u8} sensorId：Temperature sensor ID（Range：0~3）
+ * 发完命令CS保持拉低，接着用spi_rd_temperature_sensor_next分段读，读够了调用spi_rd_temperature_sensor_end。
+ */
+void spi_rd_temperature_sensor_begin(u8 sensorId)
+{
     set_spi_cs_pin(SET_LOW);
     spi_tx_byte(SPI_RD_TEMP_SENSOR); // CMD
     spi_tx_byte(sensorId);           // sensorId
     spi_tx_byte(0);                  // dummy data
     spi_tx_byte(0);                  // dummy data
-    for (i = 0; i < len; i++)        // Data buf
-    {
-        pBuf[i] = spi_rx_byte();
-    }
+}
+
+/**
+ * @description: Read the next part of the temperature sensor data
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ * @param {u8} *pBuf：Data buf
+ * @param {u16} len：Length of this part
+ */
+void spi_rd_temperature_sensor_next(u8 *pBuf, u16 len)
+{
+    spi_rx_bytes(pBuf, len);
+}
+
+/**
+ * @description: Finish reading the temperature sensor
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ */
+void spi_rd_temperature_sensor_end(void)
+{
     set_spi_cs_pin(SET_HIGH);
 }
+
+/**
+ * @description: Read the data of the temperature sensor inside the panel
+ * @paran:
+ * @return {*}
+ * @author: lmx
+ * @param {u8} sensorId：Temperature sensor ID（Range：0~3）
+ * @param {u8} *pBuf：Data buf
+ * @param {u16} len of pbuf(More than 2000 recommended)
+ */
+void spi_rd_temperature_sensor(u8 sensorId, u8 *pBuf, u16 len)
+{
+    spi_rd_temperature_sensor_begin(sensorId);
+    spi_rd_temperature_sensor_next(pBuf, len);  // Data buf
+    spi_rd_temperature_sensor_end();
+}
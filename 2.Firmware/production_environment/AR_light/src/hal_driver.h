@@ -18,15 +18,28 @@ typedef unsigned long long u64;
 
 
 
+void spi_init(void);                                                //Initialize the SPI bus of the panel
+u8 spi_dma_ok(void);                                                //Check whether queued DMA writes are available（0 after falling back to Arduino SPI）
 void delay_us(u32 val);                                             //Delay N us
 void delay_ms(u32 val);                                             //Delay N ms
+u32 get_time_us(void);                                              //Microseconds since boot
 void spi_wr_byte(u8 param);                                         //Write a byte of data
 u8 spi_rd_byte(u8 cmd);                                             //Read a byte of data
 void spi_wr_bytes(u8 cmd, u8 *pBuf, u32 len);                       //Write multiple bytes data
 void spi_rd_bytes(u8 cmd, u8 *pBuf, u32 len);                       //Read multiple bytes data
 void spi_rd_cache(u16 col, u16 row, u8 *pBuf, u32 len);             //Read data from the panel cache
 void spi_wr_cache(u16 col, u16 row, u8 *pBuf, u32 len);             //Write data to the cache in the panel
+void spi_wr_cache_end(u16 col, u16 row, u8 *pBuf, u32 len, u8 endPixel); //Write data to the cache, keeping the end pixel
+void spi_dma_wr_cache(u16 col, u16 row, u8 *pBuf, u32 len, u8 endPixel); //Queue a write to the cache（PANEL_USE_DMA only）
+void spi_dma_cmd(u8 cmd);                                           //Queue a command（PANEL_USE_DMA only）
+void spi_dma_on_done(void (*done)(void *), void *arg);              //Set the callback of the next queued transaction（PANEL_USE_DMA only）
+u32 spi_dma_stall_us(void);                                         //Get and clear the time spent waiting for a free slot（PANEL_USE_DMA only）
+void spi_dma_wait(void);                                            //Wait until all queued transactions have been sent
+u8 spi_dma_idle(void);                                              //Check whether all queued transactions have been sent, without waiting
 void spi_rd_temperature_sensor(u8 sensorId, u8 *pBuf, u16 bufSize); //Read the data of the temperature sensor inside the panel
+void spi_rd_temperature_sensor_begin(u8 sensorId);                  //Start reading the temperature sensor, CS stays low
+void spi_rd_temperature_sensor_next(u8 *pBuf, u16 len);             //Read the next part of the temperature sensor data
+void spi_rd_temperature_sensor_end(void);                           //Finish reading the temperature sensor
 
 
 
@@ -6,6 +6,11 @@
  */
 #include "jbd013_api.h"
 #include "string.h"
+#include "math.h"
+#if PANEL_USE_DMA
+#include "esp_attr.h"
+#include "esp_timer.h"
+#endif
 
 /**
  * @description: Send command
@@ -254,34 +259,18 @@ void set_mirror_mode(u8 param)
  * @return {*}
  * @author: lmx
  * 这段代码定义了一个清空缓存的函数，函数名为clr_cache，没有返回值。
- * 在函数内部，定义了一个长度为10的u8类型数组pBuf
- * 和三个变量pBufLen、addrStep、rowCnt、colCnt。
- * pBufLen的值为pBuf数组的长度，addrStep的值为pBufLen乘以2。
- * 调用了memset函数，将pBuf数组的所有元素都设置为0。
- * 通过两个嵌套的for循环，将pBuf数组中的数据写入缓存中的每个地址。
- * 如果640除以addrStep的余数不为0，则需要额外写入一部分数据以保证完整。
+ * 一次写一整行（640个像素，320字节），480行共480次传输；原来每次只写10字节，一行要32次。
+ * 一行比PANEL_DMA_ROW长，PANEL_USE_DMA时也是同步写，只有后面的打开显示和SYNC排进DMA队列。
  */
 void clr_cache(void)
 {
-    u8 pBuf[10];
-    u8 addrStep;
-    u32 pBufLen;
+    u8 pBuf[320];
     u16 rowCnt;
-    u16 colCnt;
 
-    pBufLen = sizeof(pBuf);
-    addrStep = pBufLen * 2;
-    memset(pBuf, 0, pBufLen);
+    memset(pBuf, 0, sizeof(pBuf));
     for (rowCnt = 0; rowCnt < 480; rowCnt++)
     {
-        for (colCnt = 0; colCnt < 640; colCnt += addrStep)
-        {
-            spi_wr_cache(colCnt, rowCnt, pBuf, pBufLen);
-        }
-        if (640 % addrStep != 0)
-        {
-            spi_wr_cache((640 - 640 % addrStep), rowCnt, pBuf, 640 % addrStep);
-        }
+        spi_wr_cache(0, rowCnt, pBuf, sizeof(pBuf));
     }
 }
 
@@ -314,6 +303,89 @@ void send_line(int x,int y,  u8 *line, int w)
 }
 
 
+static volatile u32 syncUs = 0;     // 上一次 SYNC 的时间，sync_sent 在 SPI 中断里也会写
+static volatile u8 syncBusy = 0;    // 发了 SYNC 还没等过
+static u8 syncQueued = 0;  // SYNC 排进了 DMA 队列，可能还没发出去
+
+/**
+ * @description: Send SYNC without waiting
+ * @paran: 
+ * @return {*}
+ * @author: lmx
+ * 发送SPI_SYNC后只记下时间，不在这里延时1毫秒；
+ * 下一次访问缓存之前调用panel_sync_wait，只等还没过完的那部分。
+ * 刷新之间隔得比1毫秒久时（通常都是这样），就完全不用等。
+ */
+void panel_sync(void)
+{
+    send_cmd(SPI_SYNC);
+    syncUs = get_time_us();
+    syncBusy = 1;
+}
+
+#if PANEL_USE_DMA
+// 在 SPI 中断里调用，cache 关着的时候也可能跑，要放在 IRAM，不能调 flash 里的 get_time_us
+static void IRAM_ATTR sync_sent(void *arg)
+{
+    syncUs = (u32)esp_timer_get_time();
+    syncBusy = 1;
+}
+
+/**
+ * @description: Queue SYNC after the queued cache writes
+ * @paran: 
+ * @return {*}
+ * @author: lmx
+ * 和panel_sync一样不等，只是排在spi_dma_*写缓存的后面；发出去的时间在SPI中断里记下。
+ */
+void panel_sync_async(void)
+{
+    syncQueued = 1;
+    spi_dma_on_done(sync_sent, NULL);
+    spi_dma_cmd(SPI_SYNC);
+}
+#endif
+
+/**
+ * @description: Time the last SYNC was sent
+ * @paran: 
+ * @return {u32}：time，unit：us
+ * @author: lmx
+ */
+u32 panel_sync_time(void)
+{
+    return syncUs;
+}
+
+/**
+ * @description: Wait until the last SYNC has finished
+ * @paran: 
+ * @return {u32}：actual waiting time，unit：us
+ * @author: lmx
+ */
+u32 panel_sync_wait(void)
+{
+    u32 elapsed;
+    u32 wait = 0;
+
+    if (syncQueued)         //先等排着队的SYNC发出去，同一次刷新里的几块之间不用等
+    {
+        spi_dma_wait();
+        syncQueued = 0;
+    }
+    if (syncBusy)
+    {
+        elapsed = get_time_us() - syncUs;
+        if (elapsed < PANEL_SYNC_US)
+        {
+            wait = PANEL_SYNC_US - elapsed;
+            delay_us(wait);
+        }
+        syncBusy = 0;
+    }
+    return wait;
+}
+
 /**
  * @description: Reset panel
  * @paran: 
@@ -338,11 +410,11 @@ void panel_rst(void)
  * 这段代码定义了一个初始化面板的函数，函数名为panel_init，没有返回值。
  * 在函数内部，首先调用panel_rst函数进行面板复位。然后调用send_cmd函数发送命令SPI_WR_ENABLE，打开状态寄存器的写使能。
  * 再调用wr_status_reg函数，写入特定的值0x10到状态寄存器中，以关闭demura。
- * 通过调用clr_cache函数，将所有缓存数据清零。
- * 接着调用wr_offset_reg函数设置偏移寄存器的值，分别设置四个角以及实际偏移值，将屏幕居中。
+ * 接着调用wr_offset_reg函数设置偏移寄存器的值，将屏幕居中。
+ * 原来先依次写四个角再写实际偏移，偏移寄存器只有一个，前四次都被最后一次覆盖，每次还要SYNC等1毫秒，已去掉。
  * 再调用wr_cur_reg函数设置电流寄存器的值为63。
- * 最后，通过调用send_cmd函数发送命令SPI_DISPLAY_ENABLE，打开显示使能。
- * 最后发送命令SPI_SYNC进行同步操作，并延时1毫秒，等待同步操作完成。
+ * 寄存器都设好以后再清缓存，PANEL_USE_DMA时打开显示和SYNC走DMA队列，排进去就返回。
+ * SYNC用panel_sync/panel_sync_async发，不在这里延时，下一次写缓存前才等。
  */
 void panel_init(void)
 {
@@ -355,117 +427,170 @@ void panel_init(void)
     //Close demura
     wr_status_reg(SPI_WR_STATUS_REG1, 0x30);
 
-    //Set all cache data to 0
-    clr_cache();
-
-    //Set the offset in the upper left corner
-    wr_offset_reg(0, 0);
-
-    //Set the offset in the upper right corner
-    wr_offset_reg(0, 20);
-
-    //Set the offset in the lower left corner
-    wr_offset_reg(24, 0);
-
-    //Set the offset in the lower right corner
-    wr_offset_reg(24, 20);
-
     //Set actual offset,center the screen
     wr_offset_reg(12, 10);
 
     //Set current reg
     wr_cur_reg(63);
 
+    //Set all cache data to 0
+    clr_cache();
+
+#if PANEL_USE_DMA
+    //Set display enable
+    spi_dma_cmd(SPI_DISPLAY_ENABLE);
+
+    //Synchronous setting
+    panel_sync_async();
+#else
     //Set display enable
     send_cmd(SPI_DISPLAY_ENABLE);
 
     //Synchronous setting
-    send_cmd(SPI_SYNC);
-    delay_ms(1);
+    panel_sync();
+#endif
 }
 
 /**
- * @description: Get temperature sensor data
+ * @description: Measure the time of writing a full frame
  * @paran: 
- * @return {float}：Temperature data(Unit:℃)
+ * @return {u32}：time，unit：us
  * @author: lmx
- * @param {u8} sensorId：Temperature sensor ID（Range：0~3）
- * 这段代码定义了一个获取温度传感器数据的函数，函数名为get_temperature_sensor_data，
- * 返回值为一个float类型的温度数据（单位：℃）。
- * 函数接受一个u8类型的参数sensorId，表示温度传感器的ID（范围为0~3）。
- * 在函数内部，定义了一个长度为2000的u8类型数组pBuf和一个长度为8的u8类型数组maskBuf，用于存储温度传感器数据和掩码数据。
- * 还定义了一些临时变量如tmpNum、isFlag、tmpVal、i、rxBitCnt和bitCnt。
- * 通过调用spi_rd_temperature_sensor函数，将sensorId作为参数传递给该函数，
- * 读取面板内部温度传感器的数据，并存储在pBuf数组中。
- * 接下来，通过for循环和一些逻辑判断的方式解析数据。
- * 遍历pBuf数组中的每个元素，如果元素的值大于0，则将其赋值给tmpNum。
- * 然后通过嵌套的for循环，遍历tmpNum的每个bit位，
- * 根据特定的位操作，解析出温度数据，并将其存储在tmpVal变量中。
- * 最后，通过一系列的数学计算，将tmpVal转换为温度数据（单位：℃），并返回。
+ * 按LVGL整屏刷新的写法，480行每行240字节加末尾像素逐行写进缓存，不发SYNC。
+ * 写的是全0，启动时屏幕本来就是黑的。PANEL_BENCH=1时在初始化后调用，用来比较两种传输方式。
  */
-float get_temperature_sensor_data(u8 sensorId)
+u32 panel_bench(void)
 {
-    u8 pBuf[2000];
-    u8 maskBuf[] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
-    u8 tmpNum;
-    u8 isFlag;
-    u16 tmpVal = 0;
-    u16 i;
-    char rxBitCnt = -2;
-    char bitCnt;
+    u8 pBuf[PANEL_WIDTH / 2];
+    u32 t0;
+    u16 row;
 
-    spi_rd_temperature_sensor(sensorId, pBuf, sizeof(pBuf)); //Read the data of the temperature sensor inside the panel
+    memset(pBuf, 0, sizeof(pBuf));
+    t0 = get_time_us();
+    for (row = 0; row < PANEL_HEIGHT; row++)
+    {
+        spi_wr_cache(0, row, pBuf, sizeof(pBuf));
+    }
+    return get_time_us() - t0;
+}
 
-    for (i = 0, isFlag = 0; i < 2000; i++) //Parsing data
+struct temp_parser
+{
+    u8 isFlag;              // 同步位 1 0 0 1 已经对上了几位
+    int rxBitCnt;           // -2：还在找同步位；11~0：下一位数据的位置；-1：收完
+    u16 tmpVal;
+};
+
+/**
+ * @description: Parse a part of the temperature sensor data
+ * @paran:
+ * @return {u8}：1：the value has been parsed
+ * @author: lmx
+ * 逐位走和原来一样的状态机：先找 1 0 0 1 的同步位，后面 12 位高位在前就是温度值。
+ * 全0字节和原来一样整个跳过，同步位从头找，收数据位时也不计位数。
+ * 位计数用int：C3上char是无符号的，原来的char计数永远>=0，解析不会结束。
+ */
+static u8 temp_parse(struct temp_parser *p, const u8 *pBuf, u16 len)
+{
+    u16 i;
+    int bitCnt;
+    u8 bit;
+
+    for (i = 0; i < len; i++)
     {
-        if (pBuf[i] > 0)
+        if (pBuf[i] == 0)
         {
-            tmpNum = pBuf[i];
-
-            for (bitCnt = 7; bitCnt >= 0; bitCnt--)
+            p->isFlag = 0;
+            continue;
+        }
+        for (bitCnt = 7; bitCnt >= 0; bitCnt--)
+        {
+            bit = (pBuf[i] >> bitCnt) & 1;
+            if (p->rxBitCnt == -2)
             {
-                if (rxBitCnt == -2)
+                if (p->isFlag == 0 && bit)
+                {
+                    p->isFlag = 1;
+                }
+                else if ((p->isFlag == 1 || p->isFlag == 2) && !bit)
                 {
-                    if (isFlag == 0 && ((tmpNum & maskBuf[bitCnt]) >= 1))
-                    {
-                        isFlag = 1;
-                    }
-                    else if (isFlag == 1 && ((tmpNum & maskBuf[bitCnt]) == 0))
-                    {
-                        isFlag = 2;
-                    }
-                    else if (isFlag == 2 && ((tmpNum & maskBuf[bitCnt]) == 0))
-                    {
-                        isFlag = 3;
-                    }
-                    else if (isFlag == 3 && ((tmpNum & maskBuf[bitCnt]) >= 1))
-                    {
-                        isFlag = 4;
-                        rxBitCnt = 11;
-                        continue;
-                    }
-                    else
-                    {
-                        isFlag = 0;
-                    }
+                    p->isFlag++;
                 }
-                if (rxBitCnt >= 0)
+                else if (p->isFlag == 3 && bit)
                 {
-                    tmpVal |= (((tmpNum & maskBuf[bitCnt]) >> bitCnt) << rxBitCnt);
-                    rxBitCnt--;
-                    if (rxBitCnt == -1)
-                        break;
+                    p->isFlag = 4;
+                    p->rxBitCnt = 11;
                 }
+                else
+                {
+                    p->isFlag = 0;
+                }
+                continue;
+            }
+            p->tmpVal |= bit << p->rxBitCnt;
+            p->rxBitCnt--;
+            if (p->rxBitCnt == -1)
+            {
+                return 1;
             }
         }
-        else
+    }
+    return 0;
+}
+
+/**
+ * @description: Read the raw value of the temperature sensor, stop as soon as it has been parsed
+ * @paran:
+ * @return {u16}：Raw value（12 bit），TEMP_NONE：not found or aborted
+ * @author: lmx
+ * @param {u8} sensorId：Temperature sensor ID（Range：0~3）
+ * @param {u8 (*)(void)} abort：Checked before each part，return 1 to give up（NULL：never）
+ * 每次读TEMP_CHUNK字节马上解析，解析出来就拉高CS不再读，最多读TEMP_READ_MAX字节。
+ * 栈上只要一段的缓冲；abort让调用者在有帧要刷时放弃这次采样，面板最多被占一段的时间。
+ */
+u16 rd_temperature_raw(u8 sensorId, u8 (*abort)(void))
+{
+    u8 pBuf[TEMP_CHUNK];
+    struct temp_parser parser = {0, -2, 0};
+    u16 ret = TEMP_NONE;
+    u16 n;
+
+    spi_rd_temperature_sensor_begin(sensorId);
+    for (n = 0; n < TEMP_READ_MAX; n += sizeof(pBuf))
+    {
+        if (abort && abort())
         {
-            isFlag = 0;
+            break;
         }
-        if (rxBitCnt == -1)
+        spi_rd_temperature_sensor_next(pBuf, sizeof(pBuf));
+        if (temp_parse(&parser, pBuf, sizeof(pBuf)))
+        {
+            ret = parser.tmpVal;
             break;
+        }
     }
-
-    return (float)((tmpVal - 1600.1) / 7.5817); //Return temperature data(Unit:℃)
+    spi_rd_temperature_sensor_end();
+    return ret;
 }
 
+/**
+ * @description: Get temperature sensor data
+ * @paran: 
+ * @return {float}：Temperature data(Unit:℃)，NAN：not found
+ * @author: lmx
+ * @param {u8} sensorId：Temperature sensor ID（Range：0~3）
+ * 这段代码定义了一个获取温度传感器数据的函数，函数名为get_temperature_sensor_data，
+ * 返回值为一个float类型的温度数据（单位：℃）。
+ * 原来先把2000字节全读到栈上再逐位解析，现在用rd_temperature_raw边读边解析，解析出来就不再读。
+ * 最后通过TEMP_RAW_TO_C把原始值转换为温度数据（单位：℃）。
+ */
+float get_temperature_sensor_data(u8 sensorId)
+{
+    u16 raw = rd_temperature_raw(sensorId, NULL);
+
+    if (raw == TEMP_NONE)
+    {
+        return NAN;
+    }
+    return TEMP_RAW_TO_C(raw); //Return temperature data(Unit:℃)
+}
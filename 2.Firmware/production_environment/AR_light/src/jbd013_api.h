@@ -14,6 +14,25 @@
 #define SPI_MOSI 5
 #define SPI_CS   4
 
+//***************** Panel transport *****************//
+#define PANEL_USE_DMA  0                    // 1：ESP-IDF spi_master，刷屏的行排进 DMA 队列；0：Arduino SPI（原来的做法）
+                                            // 引脚和时钟两种一样；还没在板子上跑过，PANEL_BENCH=1 量过再打开，spi_master 初始化失败会自己退回 Arduino SPI
+#define PANEL_SPI_HZ   (8 * 1000 * 1000)    // 命令、寄存器、读数据和写缓存
+#define PANEL_DMA_ROW  16                   // 不超过这么长的写入拷进 DMA 槽排队发；旋转后刷屏的一行是一块的 24 列，12 字节
+#define PANEL_DMA_CHUNK 4092                // 更长的写入同步发，按这个长度分段，CS 保持拉低
+#define PANEL_DMA_QUEUE (PANEL_HEIGHT + 1)  // 排队的槽数：一块 flush 最多 480 行再加 SYNC，整块排进去不用等（要 PANEL_USE_DMA=1）
+#define PANEL_GRAY     1                    // 1：LVGL 的抗锯齿边缘按 16 级灰度显示；0：只有亮灭
+#define PANEL_GAMMA    2.2f                 // 8 位亮度换成面板灰度时的 gamma，界面和图片共用
+#define PANEL_BENCH    0                    // 1：启动时测一次整屏写缓存的耗时并打印
+
+#define PANEL_WIDTH  480     // 可见区域，缓存本身是 640x480
+#define PANEL_HEIGHT 480
+#define PANEL_SYNC_US 1000   // SYNC 之后这么久才能再写缓存（8MHz 系统时钟 1ms，16MHz 0.5ms）
+#define TEMP_CHUNK    32     // 读温度传感器时每次读这么多字节就解析一次，解析出来就停
+#define TEMP_READ_MAX 2000   // 最多读这么多字节还没找到就算失败
+#define TEMP_NONE     0xffff // rd_temperature_raw 没读到
+#define TEMP_RAW_TO_C(raw) (((raw) - 1600.1f) / 7.5817f)   // 原始值换成温度（℃）
+
 //***************** JBD013VGA instruction *****************//
 #define SPI_RD_ID 0x9f
 #define SPI_RD_UID 0xab
@@ -72,9 +91,15 @@ void set_mirror_mode(u8 param);                 //Set mirror mode
 void clr_cache(void);                           //Write the data in cache to 0
 void display_image(u8 *pBuf, u32 len,u8 X,u8 Y);          //Display image
 void send_line(int x,int y,  u8 *line, int w);
+void panel_sync(void);                          //Send SYNC without waiting
+void panel_sync_async(void);                    //Queue SYNC after the queued cache writes（PANEL_USE_DMA only）
+u32 panel_sync_time(void);                      //Time the last SYNC was sent
+u32 panel_sync_wait(void);                      //Wait until the last SYNC has finished
 void panel_rst(void);                           //Reset panel
 void panel_init(void);                          //Initialize panel
+u32 panel_bench(void);                          //Measure the time of writing a full frame
 float get_temperature_sensor_data(u8 sensorId); //Get temperature sensor data
+u16 rd_temperature_raw(u8 sensorId, u8 (*abort)(void)); //Read the raw value of the temperature sensor, stop as soon as it has been parsed
 
 
 
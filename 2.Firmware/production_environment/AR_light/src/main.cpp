@@ -2,6 +2,11 @@
 #include "myoled.h"
 #include "lvgl.h"
 #include "my_uart.h"
+#include "my_image.h"
+#include "my_dlist.h"
+#include "my_glyph.h"
+#include "my_thermal.h"
+#include "my_bench.h"
 #include "generated/gui_guider.h"
 #include "font_alipuhui20.h"
 
@@ -9,16 +14,31 @@ lv_ui  guider_ui;
 
 
 void setup() {
+    boot_mark("setup");
     Serial.begin(115200);
+    my_uart_init();                 // 先起串口任务，面板初始化的时候 S3 就可以开始协商波特率
+    boot_mark("串口");
     bsp_lvgl_init();
-    my_uart_init();
+    boot_mark("LVGL");
+    my_image_init();
     Serial.println("Starting display sequence...");
     // lv_demo_benchmark(); 
     setup_ui(&guider_ui);
+    boot_mark("setup_ui");
+    my_glyph_init();
+    my_dlist_init();
+    my_thermal_init();
+    render_sleep_init();
+    boot_mark("setup 结束");
 }
 
 void loop() {
-      onDataReceived();
-   lv_timer_handler();
-   delay(5);
+   onDataReceived();
+   uint32_t next_ms = lv_timer_handler();
+   glyph_poll();
+   my_uart_ack_rendered();
+   thermal_poll();                 // 空闲时才采温度，来帧就让路
+   boot_report();
+   bench_poll();                   // S3 要求的显示基准测试，跑完才返回
+   render_wait(next_ms);           // 没事做就睡，来帧或者 LVGL 定时器到期再醒
 }
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "my_bench.h"
+#include "lvgl.h"
+#include "jbd013_api.h"
+#include "my_uart.h"
+#include "my_image.h"
+#include "generated/gui_guider.h"
+extern lv_ui guider_ui;
+
+//-----------------显示基准测试-----------------//
+// S3 发 AR_LINK_BENCH_REQ 后，loop() 换到一个临时屏幕上把一组固定场景跑完，每个场景统计全部帧的合计：
+//   总时间   第一帧开始到最后一帧的 SYNC 做完
+//   绘制     lv_refr_now() 里除去 flush 的时间，也就是 LVGL 画到缓冲
+//   打包     LVGL 像素 -> 面板 4bpp（pixel_pack）
+//   SPI      flush 里除去打包和等 SYNC 的时间（Arduino SPI 是传输本身，PANEL_USE_DMA 时是拷进 DMA 队列和等空位），
+//            加上每帧刷完以后等 DMA 发完、SYNC 做完的时间
+//   等 SYNC  flush 开头等上一次 SYNC 做完
+// 图片场景由 C3 生成 RGB565 数据，走 image_begin()/image_data()，和 S3 发来的图片同一条解码写屏路径，
+// 绘制一栏是生成数据、解码和抖动的时间，SPI 是图片任务写屏的时间。
+// 跑完切回原来的屏幕整屏重绘，结果逐个场景用 AR_LINK_BENCH_RESULT 发给 S3，串口也打印一份。
+
+struct bench_result
+{
+    u32 frames;
+    u32 total_us;
+    u32 render_us;
+    u32 pack_us;
+    u32 spi_us;
+    u32 sync_us;
+    u32 bytes;
+};
+
+static volatile bool bench_pending = false;
+static lv_obj_t *bench_scr = NULL;
+static lv_obj_t *page = NULL;
+static lv_obj_t *bar = NULL;
+static lv_obj_t *clock_label = NULL;
+
+static u32 scene_t0 = 0;
+static u32 refr_us = 0;                           // 这个场景 lv_refr_now() 的时间
+static u32 tail_us = 0;                           // 这个场景每帧刷完后等 DMA 和 SYNC 的时间
+
+#define PAGE_Y 100                                // 和 screen_label_1 一样的位置和大小
+#define PAGE_H 280
+
+// 两页轮流显示，每帧整块文字都要重画
+static const char *const bench_pages[2] = {
+    "眼镜通过蓝牙接收手机发来的文件，按页显示在眼前。每一页大约三百个字，"
+    "翻页时文件名、正文、进度条和页码在同一帧里发过来，只刷新一次。"
+    "字库里没有的字由主控从存储卡上取出字形，显示端放进缓存，下次就不用再要。"
+    "图片在显示端边收边解码，转成十六级灰度以后直接写到面板。"
+    "面板过热时自动降低亮度和电流，温度回落以后再恢复。"
+    "没有内容要刷新的时候，显示端睡眠等待，来数据或者定时器到期再醒来。",
+    "这是第二页的内容，字数和第一页差不多，用来保证每一帧的正文都不一样。"
+    "阅读的时候，用户按键或者在手机上点下一页，主控读出文件里对应的一段，"
+    "排好版以后发给显示端。显示端把文字画到缓冲里，再按行打包成面板需要的格式，"
+    "通过串行接口发出去，最后发一次同步命令让整屏一起更新。"
+    "这套场景每次改动显示路径前后都跑一遍，比较帧率、绘制时间、打包时间和发出的字节数，"
+    "有退步就能马上看出来。",
+};
+
+//------------------------------计时------------------------------//
+// 等这一帧的 DMA 发完、SYNC 做完
+static void bench_settle()
+{
+    xSemaphoreTake(panel_lock, portMAX_DELAY);
+    panel_sync_wait();
+    xSemaphoreGive(panel_lock);
+}
+
+// 场景的准备（换内容、切屏）先刷掉，不算在里面
+static void scene_begin(bench_result *r)
+{
+    lv_refr_now(NULL);
+    bench_settle();
+    memset(r, 0, sizeof(*r));
+    memset(&disp_perf, 0, sizeof(disp_perf));
+    refr_us = 0;
+    tail_us = 0;
+    scene_t0 = micros();
+}
+
+static void scene_frame(bench_result *r)
+{
+    u32 t0 = micros();
+    lv_refr_now(NULL);
+    u32 t1 = micros();
+    bench_settle();
+    refr_us += t1 - t0;
+    tail_us += micros() - t1;
+    r->frames++;
+}
+
+static void scene_end(bench_result *r)
+{
+    r->total_us = micros() - scene_t0;
+    r->render_us = refr_us - disp_perf.flush_us;
+    r->pack_us = disp_perf.pack_us;
+    r->sync_us = disp_perf.sync_wait_us;
+    r->spi_us = disp_perf.flush_us - disp_perf.pack_us - disp_perf.sync_wait_us + tail_us;
+    r->bytes = disp_perf.bytes;
+}
+
+//------------------------------场景------------------------------//
+static void scene_cjk(bench_result *r)
+{
+    scene_begin(r);
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        lv_label_set_text_static(page, bench_pages[(i + 1) % 2]);
+        scene_frame(r);
+    }
+    scene_end(r);
+}
+
+static void scene_bar(bench_result *r)
+{
+    scene_begin(r);
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        lv_bar_set_value(bar, (i + 1) * 100 / BENCH_FRAMES, LV_ANIM_OFF);
+        scene_frame(r);
+    }
+    scene_end(r);
+}
+
+static void scene_clock(bench_result *r)
+{
+    scene_begin(r);
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        lv_label_set_text_fmt(clock_label, "12:%02d", (i + 1) % 60);
+        scene_frame(r);
+    }
+    scene_end(r);
+}
+
+static void scene_scroll(bench_result *r)
+{
+    lv_label_set_text_static(page, bench_pages[0]);
+    scene_begin(r);
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        lv_obj_set_y(page, PAGE_Y - (i + 1) * BENCH_SCROLL_STEP);
+        scene_frame(r);
+    }
+    scene_end(r);
+    lv_obj_set_y(page, PAGE_Y);
+}
+
+// 居中显示一张斜向渐变的灰度图，每张错开一点；等图片任务写完再发下一张
+static void scene_image(bench_result *r)
+{
+    static uint8_t line[BENCH_IMG_W * 2];
+    uint8_t hdr[AR_LINK_IMG_HDR_LEN];
+    uint32_t done0, spi0, bytes0, done, spi, bytes;
+    scene_begin(r);
+    image_perf(&done0, &spi0, &bytes0);
+    for (int i = 0; i < BENCH_IMG_FRAMES; i++) {
+        hdr[0] = AR_LINK_IMG_RGB565;
+        ar_link::put_u16(hdr + 1, (PANEL_HEIGHT - BENCH_IMG_W) / 2);
+        ar_link::put_u16(hdr + 3, (PANEL_WIDTH - BENCH_IMG_H) / 2);
+        ar_link::put_u16(hdr + 5, BENCH_IMG_W);
+        ar_link::put_u16(hdr + 7, BENCH_IMG_H);
+        ar_link::put_u32(hdr + 9, BENCH_IMG_W * BENCH_IMG_H * 2);
+        image_begin(hdr, sizeof(hdr));
+        for (int y = 0; y < BENCH_IMG_H; y++) {
+            for (int x = 0; x < BENCH_IMG_W; x++) {
+                uint8_t v = x + y + i * 32;
+                uint16_t c = (v >> 3) << 11 | (v >> 2) << 5 | (v >> 3);
+                line[x * 2] = c >> 8;                 // 高字节在前，和摄像头输出一致
+                line[x * 2 + 1] = c;
+            }
+            image_data(line, sizeof(line));
+        }
+        u32 t0 = millis();
+        do {
+            vTaskDelay(1);
+            image_perf(&done, &spi, &bytes);
+        } while (done - done0 < (uint32_t)i + 1 && millis() - t0 < BENCH_IMG_TIMEOUT);
+        r->frames++;
+    }
+    r->total_us = micros() - scene_t0;
+    image_perf(&done, &spi, &bytes);
+    r->spi_us = spi - spi0;
+    r->bytes = bytes - bytes0;
+    r->render_us = r->total_us > r->spi_us ? r->total_us - r->spi_us : 0;
+    lv_obj_invalidate(bench_scr);                 // 后面的场景前整屏重绘，盖掉图片
+}
+
+//------------------------------临时屏幕------------------------------//
+// 控件的样式照 setup_scr_screen.c 里的正文、进度条和时间
+static void bench_screen_create()
+{
+    bench_scr = lv_obj_create(NULL);
+    lv_obj_set_size(bench_scr, PANEL_WIDTH, PANEL_HEIGHT);
+    lv_obj_set_scrollbar_mode(bench_scr, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_clear_flag(bench_scr, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_opa(bench_scr, 0, LV_PART_MAIN);
+
+    page = lv_label_create(bench_scr);
+    lv_label_set_text_static(page, bench_pages[0]);
+    lv_label_set_long_mode(page, LV_LABEL_LONG_WRAP);
+    lv_obj_set_pos(page, 0, PAGE_Y);
+    lv_obj_set_size(page, PANEL_WIDTH, PAGE_H);
+    lv_obj_set_style_text_font(page, lv_obj_get_style_text_font(guider_ui.screen_label_1, LV_PART_MAIN), LV_PART_MAIN);
+    lv_obj_set_style_text_color(page, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_text_align(page, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+
+    bar = lv_bar_create(bench_scr);
+    lv_bar_set_range(bar, 0, 100);
+    lv_bar_set_value(bar, 0, LV_ANIM_OFF);
+    lv_obj_set_pos(bar, 350, 10);
+    lv_obj_set_size(bar, 100, 25);
+    lv_obj_set_style_bg_opa(bar, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(bar, 20, LV_PART_MAIN);
+    lv_obj_set_style_shadow_width(bar, 10, LV_PART_MAIN);
+    lv_obj_set_style_shadow_color(bar, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_shadow_opa(bar, 134, LV_PART_MAIN);
+    lv_obj_set_style_shadow_spread(bar, 2, LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(bar, 255, LV_PART_INDICATOR);
+    lv_obj_set_style_bg_color(bar, lv_color_hex(0x000000), LV_PART_INDICATOR);
+    lv_obj_set_style_radius(bar, 20, LV_PART_INDICATOR);
+
+    clock_label = lv_label_create(bench_scr);
+    lv_label_set_text(clock_label, "12:00");
+    lv_obj_set_pos(clock_label, 390, 390);
+    lv_obj_set_size(clock_label, 80, 80);
+    lv_obj_set_style_border_width(clock_label, 2, LV_PART_MAIN);
+    lv_obj_set_style_border_color(clock_label, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_radius(clock_label, 40, LV_PART_MAIN);
+    lv_obj_set_style_pad_top(clock_label, 12, LV_PART_MAIN);
+    lv_obj_set_style_text_font(clock_label, lv_obj_get_style_text_font(guider_ui.screen_label_7, LV_PART_MAIN), LV_PART_MAIN);
+    lv_obj_set_style_text_color(clock_label, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_text_align(clock_label, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+}
+
+//------------------------------上报------------------------------//
+static void bench_report(int scene, const bench_result *r)
+{
+    static const char *const names[AR_BENCH_SCENES] = AR_BENCH_NAMES;
+    uint8_t msg[AR_LINK_BENCH_LEN];
+    msg[0] = scene;
+    ar_link::put_u16(msg + 1, r->frames);
+    ar_link::put_u32(msg + 3, r->total_us);
+    ar_link::put_u32(msg + 7, r->render_us);
+    ar_link::put_u32(msg + 11, r->pack_us);
+    ar_link::put_u32(msg + 15, r->spi_us);
+    ar_link::put_u32(msg + 19, r->sync_us);
+    ar_link::put_u32(msg + 23, r->bytes);
+    send_hex(AR_LINK_BENCH_RESULT, (char *)msg, sizeof(msg));
+
+    u32 n = r->frames ? r->frames : 1;
+    u32 fps10 = r->total_us ? (u32)((uint64_t)r->frames * 10000000 / r->total_us) : 0;
+    Serial.printf("基准 %-6s: %u 帧 %u.%u fps, 每帧 绘制 %u us, 打包 %u us, SPI %u us, 等 SYNC %u us, %u 字节\n", names[scene],
+                  r->frames, fps10 / 10, fps10 % 10, r->render_us / n, r->pack_us / n, r->spi_us / n, r->sync_us / n, r->bytes / n);
+}
+
+void bench_request()
+{
+    bench_pending = true;
+}
+
+void bench_poll()
+{
+    if (!bench_pending) {
+        return;
+    }
+    bench_pending = false;
+    Serial.println("显示基准测试开始");
+    bench_result res[AR_BENCH_SCENES];
+    lv_obj_t *prev = lv_scr_act();
+    bench_screen_create();
+    lv_scr_load(bench_scr);
+
+    scene_cjk(&res[AR_BENCH_CJK]);
+    scene_bar(&res[AR_BENCH_BAR]);
+    scene_clock(&res[AR_BENCH_CLOCK]);
+    scene_image(&res[AR_BENCH_IMAGE]);
+    scene_scroll(&res[AR_BENCH_SCROLL]);
+
+    lv_scr_load(prev);                            // 切回去整屏重绘，在下一次 lv_timer_handler() 里
+    lv_obj_del(bench_scr);
+    bench_scr = NULL;
+    for (int i = 0; i < AR_BENCH_SCENES; i++) {
+        bench_report(i, &res[i]);
+    }
+}
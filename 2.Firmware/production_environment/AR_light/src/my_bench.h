@@ -0,0 +1,28 @@
+#pragma once
+#include "Arduino.h"
+#include "hal_driver.h"
+#include "ar_link.h"
+
+#define BENCH_FRAMES        30     // LVGL 场景每个刷这么多帧
+#define BENCH_IMG_FRAMES    4      // 图片场景发这么多张
+#define BENCH_IMG_W         240    // 图片场景的 RGB565 渐变图，C3 自己生成
+#define BENCH_IMG_H         160
+#define BENCH_IMG_TIMEOUT   2000   // 一张图最多等这么久写完，ms
+#define BENCH_SCROLL_STEP   8      // 滚动场景每帧移动的像素
+
+#define DISP_LOG_REFRESH    0      // 1: 每次刷新打印一行 flush 统计，调刷屏时打开；平时关掉，串口打印会算进刷新时间
+#define DISP_LOG(...)       do { if (DISP_LOG_REFRESH) Serial.printf(__VA_ARGS__); } while (0)
+
+// 刷屏的累计统计，每次刷新最后一块 flush 时加进来（myoled.h），基准测试开始一个场景前清零
+struct disp_perf_t
+{
+    u32 refreshes;
+    u32 flush_us;                  // flush 里的时间，含打包、等 DMA 空位和等 SYNC
+    u32 pack_us;
+    u32 sync_wait_us;
+    u32 bytes;                     // SPI 上发出的字节数，含命令、地址和 SYNC
+};
+extern disp_perf_t disp_perf;      // myoled.h
+
+void bench_request();              // 接收任务收到 AR_LINK_BENCH_REQ 时调用，真正跑在 loop() 里
+void bench_poll();                 // 在 loop() 里调用
@@ -0,0 +1,208 @@
+#include "my_dlist.h"
+#include "my_uart.h"
+#include "lvgl.h"
+#include "generated/gui_guider.h"
+extern lv_ui guider_ui;
+
+//-----------------显示列表-----------------//
+// S3 已经按行排好版（见 ar_link.h 的 'o' 帧），这里只按码点取字形画到指定位置。
+// label 每画一块（20 行的绘制缓冲一块）都要从头断行、量宽度，一页要重复十几次；
+// 显示列表只画和当前裁剪区相交的行，也不用在 set_text 时拷贝、重新排版整段文字。
+// 列表画在一个全屏透明的对象上，放在其他控件上面；有列表时把 screen_label_1 和 screen_bar_1 藏起来。
+
+static uint8_t dl_buf[LINK_FRAME_MAX];
+static size_t dl_len = 0;
+static bool dl_active = false;
+static lv_obj_t *dl_obj = NULL;
+
+uint32_t content_draw_us = 0;
+static uint32_t draw_t0 = 0;
+
+static int text_width(const lv_font_t *font, const ar_link::DlOp &op)
+{
+    int w = 0;
+    for (int i = 0; i < op.n; i++) {
+        uint32_t cp = ar_link::get_u16(op.cps + i * 2);
+        uint32_t next = i + 1 < op.n ? ar_link::get_u16(op.cps + i * 2 + 2) : 0;
+        w += lv_font_get_glyph_width(font, cp, next);
+    }
+    return w;
+}
+
+// 一条指令覆盖的区域，列表坐标就是屏幕坐标
+static void op_area(const ar_link::DlOp &op, lv_area_t *a)
+{
+    a->x1 = op.x;
+    a->y1 = op.y;
+    if (op.op == AR_DL_TEXT) {
+        a->x2 = op.x + (op.w ? op.w : text_width(&DLIST_FONT, op)) - 1;
+        a->y2 = op.y + lv_font_get_line_height(&DLIST_FONT) - 1;
+    } else {
+        a->x2 = op.x + op.w - 1;
+        a->y2 = op.y + op.h - 1;
+    }
+}
+
+// 旧列表和新列表各自的区域都要重画，LVGL 会把重叠的区域合并
+static void invalidate_ops()
+{
+    size_t pos = 0;
+    ar_link::DlOp op;
+    lv_area_t a;
+    while (ar_link::dl_next(dl_buf, dl_len, &pos, &op)) {
+        op_area(op, &a);
+        lv_obj_invalidate_area(dl_obj, &a);
+    }
+}
+
+//------------------------------绘制------------------------------//
+static void draw_text(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc, const ar_link::DlOp &op)
+{
+    const lv_area_t *clip = draw_ctx->clip_area;
+    int line_h = lv_font_get_line_height(dsc->font);
+    if (op.y + line_h <= clip->y1 || op.y > clip->y2) {
+        return;                                    // 这一行不在当前块里
+    }
+    lv_point_t pos = {op.x, op.y};
+    if (op.arg != AR_DL_ALIGN_LEFT && op.w) {
+        int tw = text_width(dsc->font, op);
+        pos.x += op.arg == AR_DL_ALIGN_CENTER ? (op.w - tw) / 2 : op.w - tw;
+    }
+    for (int i = 0; i < op.n && pos.x <= clip->x2; i++) {
+        uint32_t cp = ar_link::get_u16(op.cps + i * 2);
+        uint32_t next = i + 1 < op.n ? ar_link::get_u16(op.cps + i * 2 + 2) : 0;
+        lv_draw_letter(draw_ctx, dsc, &pos, cp);
+        pos.x += lv_font_get_glyph_width(dsc->font, cp, next);
+    }
+}
+
+static void draw_rect(lv_draw_ctx_t *draw_ctx, const ar_link::DlOp &op)
+{
+    lv_area_t a;
+    op_area(op, &a);
+    if (!_lv_area_is_on(&a, draw_ctx->clip_area)) {
+        return;
+    }
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.radius = op.arg;
+    dsc.bg_color = op.lit ? lv_color_black() : lv_color_white();   // 黑色是点亮
+    lv_draw_rect(draw_ctx, &dsc, &a);
+}
+
+// 进度条：圆角外框加填充，代替 screen_bar_1 的阴影样式（阴影要做模糊，很费 CPU）
+static void draw_bar(lv_draw_ctx_t *draw_ctx, const ar_link::DlOp &op)
+{
+    lv_area_t a;
+    op_area(op, &a);
+    if (!_lv_area_is_on(&a, draw_ctx->clip_area)) {
+        return;
+    }
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.radius = LV_RADIUS_CIRCLE;
+    dsc.bg_opa = LV_OPA_TRANSP;
+    dsc.border_color = lv_color_black();
+    dsc.border_width = 2;
+    lv_draw_rect(draw_ctx, &dsc, &a);
+    if (op.arg) {
+        a.x2 = a.x1 + op.w * op.arg / 100 - 1;
+        dsc.bg_opa = LV_OPA_COVER;
+        dsc.bg_color = lv_color_black();
+        dsc.border_width = 0;
+        lv_draw_rect(draw_ctx, &dsc, &a);
+    }
+}
+
+static void dl_draw_cb(lv_event_t *e)
+{
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_label_dsc_init(&label_dsc);
+    label_dsc.font = &DLIST_FONT;
+    label_dsc.color = lv_color_black();
+
+    size_t pos = 0;
+    ar_link::DlOp op;
+    while (ar_link::dl_next(dl_buf, dl_len, &pos, &op)) {
+        switch (op.op) {
+        case AR_DL_TEXT: draw_text(draw_ctx, &label_dsc, op); break;
+        case AR_DL_RECT: draw_rect(draw_ctx, op); break;
+        case AR_DL_BAR:  draw_bar(draw_ctx, op); break;
+        }
+    }
+}
+
+// 挂在 screen_label_1 和显示列表对象上，两条路径的绘制耗时记在同一个计数里，方便对比
+static void draw_time_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN_BEGIN) {
+        draw_t0 = micros();
+    } else {
+        content_draw_us += micros() - draw_t0;
+    }
+}
+
+//------------------------------接口------------------------------//
+void dlist_apply(const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        dlist_off();
+        return;
+    }
+    uint32_t t0 = micros();
+    // 先整个检查一遍，格式不对就保留旧的列表
+    size_t pos = 0;
+    int count = 0;
+    ar_link::DlOp op;
+    while (ar_link::dl_next(data, len, &pos, &op)) {
+        count++;
+    }
+    if (pos != len || len > sizeof(dl_buf)) {
+        Serial.printf("显示列表格式错误: %u 字节，第 %d 条\n", (unsigned)len, count);
+        return;
+    }
+    invalidate_ops();
+    memcpy(dl_buf, data, len);
+    dl_len = len;
+    invalidate_ops();
+    if (!dl_active) {
+        lv_obj_add_flag(guider_ui.screen_label_1, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_flag(guider_ui.screen_bar_1, LV_OBJ_FLAG_HIDDEN);
+        dl_active = true;
+    }
+    LINK_LOG("显示列表: %d 条, %u 字节, 应用 %lu us\n", count, (unsigned)len, (unsigned long)(micros() - t0));
+}
+
+void dlist_off()
+{
+    if (!dl_active) {
+        return;
+    }
+    invalidate_ops();
+    dl_len = 0;
+    lv_obj_clear_flag(guider_ui.screen_label_1, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_flag(guider_ui.screen_bar_1, LV_OBJ_FLAG_HIDDEN);
+    dl_active = false;
+}
+
+void dlist_invalidate()
+{
+    if (dl_active) {
+        invalidate_ops();
+    }
+}
+
+void my_dlist_init()
+{
+    dl_obj = lv_obj_create(guider_ui.screen);
+    lv_obj_remove_style_all(dl_obj);                           // 全透明，对象本身什么都不画
+    lv_obj_set_pos(dl_obj, 0, 0);
+    lv_obj_set_size(dl_obj, LV_PCT(100), LV_PCT(100));
+    lv_obj_clear_flag(dl_obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(dl_obj, dl_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(dl_obj, draw_time_cb, LV_EVENT_DRAW_MAIN_BEGIN, NULL);
+    lv_obj_add_event_cb(dl_obj, draw_time_cb, LV_EVENT_DRAW_MAIN_END, NULL);
+    lv_obj_add_event_cb(guider_ui.screen_label_1, draw_time_cb, LV_EVENT_DRAW_MAIN_BEGIN, NULL);
+    lv_obj_add_event_cb(guider_ui.screen_label_1, draw_time_cb, LV_EVENT_DRAW_MAIN_END, NULL);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "Arduino.h"
+#include "ar_link.h"
+#include "my_glyph.h"
+
+#define DLIST_FONT  glyph_font   // 和 screen_label_1 同一个字体，缺字向 S3 要
+
+extern uint32_t content_draw_us;   // 本次刷新里正文（label 或显示列表）的绘制耗时，刷屏最后一块时打印并清零
+
+// setup_ui() 之后调用
+void my_dlist_init();
+// 在 loop() 里由 process_data() 调用
+void dlist_apply(const uint8_t *data, size_t len);   // 'o'
+void dlist_off();                                    // 收到 'a'/'i'/'j'/'k' 时切回 label
+void dlist_invalidate();                             // 字形缓存有新字到了，重画列表的区域
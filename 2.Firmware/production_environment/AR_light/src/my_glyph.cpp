@@ -0,0 +1,248 @@
+#include "my_glyph.h"
+#include "my_uart.h"
+#include "my_dlist.h"
+#include "generated/gui_guider.h"
+extern lv_ui guider_ui;
+
+//-----------------字形缓存-----------------//
+// 完整的 20 号中文字库放不进 flash，固件里只编了常用字；其他字由 S3 从 SD 卡字库里取（协议见 ar_link.h）。
+// LVGL 取字形时先查子集，再查这里的 LRU 缓存，都没有就记下来，loop() 里一次向 S3 要，
+// 这一帧先按 LVGL 的占位方框画；字到了以后重画用这个字体的控件。
+// 缓存只在 loop() 里（LVGL 绘制和 process_data）访问，不加锁。
+
+struct glyph_slot
+{
+    uint16_t cp;                  // 0 表示空槽
+    uint8_t adv_w;
+    uint8_t box_w, box_h;
+    int8_t ofs_x, ofs_y;
+    bool missing;                 // S3 的字库里也没有，记下来不再要
+    uint32_t used;                // 最近一次使用的序号，淘汰最小的
+    uint8_t bitmap[GLYPH_SLOT_BYTES];
+};
+
+struct glyph_pending
+{
+    uint16_t cp;
+    bool demand;                  // 绘制时缺的（不是预取），到了要重画
+    uint32_t ms;                  // 发出请求的时间，0 表示还没发
+};
+
+lv_font_t glyph_font;
+static glyph_slot slots[GLYPH_CACHE_SLOTS];
+static glyph_slot *last_hit = NULL;           // get_glyph_dsc 之后紧跟着 get_glyph_bitmap 取同一个字
+static uint32_t use_seq = 0;
+static glyph_pending pending[GLYPH_PENDING_MAX];
+static int pending_count = 0;
+
+// 统计，glyph_apply() 时打印
+static uint32_t hit_count = 0;
+static uint32_t miss_count = 0;
+
+static glyph_slot *cache_find(uint32_t cp)
+{
+    if (last_hit && last_hit->cp == cp) {
+        return last_hit;
+    }
+    for (int i = 0; i < GLYPH_CACHE_SLOTS; i++) {       // 64 个比较，只有子集里没有的字才会走到这里
+        if (slots[i].cp == cp) {
+            last_hit = &slots[i];
+            return last_hit;
+        }
+    }
+    return NULL;
+}
+
+static glyph_slot *cache_alloc(uint16_t cp)
+{
+    glyph_slot *s = cache_find(cp);
+    if (s) {
+        return s;
+    }
+    s = &slots[0];
+    for (int i = 0; i < GLYPH_CACHE_SLOTS; i++) {
+        if (slots[i].cp == 0) {
+            s = &slots[i];
+            break;
+        }
+        if (slots[i].used < s->used) {
+            s = &slots[i];
+        }
+    }
+    s->cp = cp;
+    return s;
+}
+
+static glyph_pending *pending_find(uint16_t cp)
+{
+    for (int i = 0; i < pending_count; i++) {
+        if (pending[i].cp == cp) {
+            return &pending[i];
+        }
+    }
+    return NULL;
+}
+
+// 记下一个缺的字，下一次 glyph_poll() 时发出请求
+static void want(uint32_t cp, bool demand)
+{
+    glyph_pending *p = pending_find(cp);
+    if (p) {
+        p->demand |= demand;
+        return;
+    }
+    if (pending_count == GLYPH_PENDING_MAX) {
+        return;                                      // 下次绘制还会再缺，到时候再要
+    }
+    pending[pending_count++] = {(uint16_t)cp, demand, 0};
+}
+
+static bool base_has(uint32_t cp)
+{
+    lv_font_glyph_dsc_t dsc;
+    return GLYPH_BASE_FONT.get_glyph_dsc(&GLYPH_BASE_FONT, &dsc, cp, 0);
+}
+
+//------------------------------LVGL 字体接口------------------------------//
+static bool glyph_get_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc, uint32_t letter, uint32_t letter_next)
+{
+    if (GLYPH_BASE_FONT.get_glyph_dsc(&GLYPH_BASE_FONT, dsc, letter, letter_next)) {
+        return true;
+    }
+    if (letter < 0x80 || letter > 0xffff) {
+        return false;                                // ASCII 子集里都有，没有的是控制字符
+    }
+    glyph_slot *s = cache_find(letter);
+    if (!s) {
+        miss_count++;
+        want(letter, true);
+        return false;
+    }
+    s->used = ++use_seq;
+    if (s->missing) {
+        return false;
+    }
+    hit_count++;
+    dsc->adv_w = s->adv_w;
+    dsc->box_w = s->box_w;
+    dsc->box_h = s->box_h;
+    dsc->ofs_x = s->ofs_x;
+    dsc->ofs_y = s->ofs_y;
+    dsc->bpp = 4;
+    dsc->is_placeholder = false;
+    return true;
+}
+
+static const uint8_t *glyph_get_bitmap(const lv_font_t *font, uint32_t letter)
+{
+    const uint8_t *b = GLYPH_BASE_FONT.get_glyph_bitmap(&GLYPH_BASE_FONT, letter);
+    if (b) {
+        return b;
+    }
+    glyph_slot *s = cache_find(letter);
+    return s && !s->missing ? s->bitmap : NULL;
+}
+
+//------------------------------收发------------------------------//
+void glyph_poll()
+{
+    uint8_t req[GLYPH_PENDING_MAX * 2];
+    int n = 0;
+    uint32_t now = millis();
+    for (int i = 0; i < pending_count; i++) {
+        if (pending[i].ms == 0 || now - pending[i].ms > GLYPH_RETRY_MS) {
+            ar_link::put_u16(req + n * 2, pending[i].cp);
+            pending[i].ms = now ? now : 1;
+            n++;
+        }
+    }
+    if (n > 0) {
+        send_hex(AR_LINK_GLYPH_REQ, (char *)req, n * 2);
+    }
+}
+
+// 字到了，重画用这个字体的控件；显示列表只重画自己的区域
+static void glyph_redraw()
+{
+    lv_obj_t *scr = guider_ui.screen;
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(scr); i++) {
+        lv_obj_t *obj = lv_obj_get_child(scr, i);
+        if (lv_obj_get_style_text_font(obj, LV_PART_MAIN) == &glyph_font) {
+            lv_obj_invalidate(obj);
+        }
+    }
+    dlist_invalidate();
+}
+
+void glyph_apply(const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+    int count = 0;
+    bool redraw = false;
+    uint32_t wait_ms = 0;
+    while (pos + AR_GLYPH_HDR <= len) {
+        const uint8_t *r = data + pos;
+        uint16_t cp = ar_link::get_u16(r);
+        uint8_t box_w = r[3], box_h = r[4];
+        size_t n = ar_link::glyph_bitmap_len(box_w, box_h);
+        if (pos + AR_GLYPH_HDR + n > len) {
+            Serial.printf("字形帧格式错误: U+%04X\n", cp);
+            break;
+        }
+        glyph_slot *s = cache_alloc(cp);
+        s->missing = box_w > GLYPH_BOX_MAX || box_h > GLYPH_BOX_MAX || (r[2] == 0 && n == 0);
+        s->adv_w = r[2];
+        s->box_w = box_w;
+        s->box_h = box_h;
+        s->ofs_x = (int8_t)r[5];
+        s->ofs_y = (int8_t)r[6];
+        s->used = ++use_seq;
+        if (!s->missing) {
+            memcpy(s->bitmap, r + AR_GLYPH_HDR, n);
+        }
+        glyph_pending *p = pending_find(cp);
+        if (p) {
+            redraw |= p->demand;
+            uint32_t w = p->ms ? millis() - p->ms : 0;
+            if (w > wait_ms) {
+                wait_ms = w;
+            }
+            *p = pending[--pending_count];
+        }
+        pos += AR_GLYPH_HDR + n;
+        count++;
+    }
+    if (redraw) {
+        glyph_redraw();
+    }
+    LINK_LOG("字形: 收到 %d 个, 最久等了 %lu ms, 缓存命中 %lu 缺 %lu\n", count, (unsigned long)wait_ms,
+             (unsigned long)hit_count, (unsigned long)miss_count);
+}
+
+void glyph_prefetch(const uint8_t *cps, size_t len)
+{
+    int before = pending_count;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint16_t cp = ar_link::get_u16(cps + i);
+        if (cp >= 0x80 && !cache_find(cp) && !base_has(cp)) {
+            want(cp, false);
+        }
+    }
+    LINK_LOG("预取: %u 个字, 缺 %d 个\n", (unsigned)(len / 2), pending_count - before);
+}
+
+void my_glyph_init()
+{
+    glyph_font = GLYPH_BASE_FONT;                 // 行高、基线等度量照搬
+    glyph_font.get_glyph_dsc = glyph_get_dsc;
+    glyph_font.get_glyph_bitmap = glyph_get_bitmap;
+    glyph_font.fallback = NULL;
+
+    lv_obj_t *scr = guider_ui.screen;
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(scr); i++) {
+        lv_obj_t *obj = lv_obj_get_child(scr, i);
+        if (lv_obj_get_style_text_font(obj, LV_PART_MAIN) == &GLYPH_BASE_FONT) {
+            lv_obj_set_style_text_font(obj, &glyph_font, LV_PART_MAIN | LV_STATE_DEFAULT);
+        }
+    }
+}
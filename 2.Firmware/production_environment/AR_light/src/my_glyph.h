@@ -0,0 +1,22 @@
+#pragma once
+#include "Arduino.h"
+#include "lvgl.h"
+#include "ar_link.h"
+
+#define GLYPH_BASE_FONT    lv_font_AlibabaPuHuiTi_20   // 固件里的子集字体
+#define GLYPH_CACHE_SLOTS  64      // 缓存的字形个数，一页常见的生僻字加上预取的下一页够用
+#define GLYPH_BOX_MAX      24      // 20 号字的字形边长不超过这个，更大的当作没有
+#define GLYPH_SLOT_BYTES   ((GLYPH_BOX_MAX * GLYPH_BOX_MAX + 1) / 2)
+#define GLYPH_PENDING_MAX  64      // 已经要了还没到的字
+#define GLYPH_RETRY_MS     1000    // 要了这么久还没到就再要一次
+
+// 包在子集字体外面的字体：子集里没有的字查缓存，缓存里也没有就记下来向 S3 要，先显示方框
+extern lv_font_t glyph_font;
+
+// setup_ui() 之后调用，把用子集字体的控件都换成 glyph_font
+void my_glyph_init();
+// 在 loop() 里由 process_data() 调用
+void glyph_apply(const uint8_t *data, size_t len);      // 'p'
+void glyph_prefetch(const uint8_t *cps, size_t len);    // 'q'
+// 在 loop() 里 lv_timer_handler() 之后调用，把这一轮绘制缺的字一次要过去
+void glyph_poll();
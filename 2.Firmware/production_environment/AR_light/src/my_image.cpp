@@ -0,0 +1,491 @@
+#include "my_image.h"
+#include "jbd013_api.h"
+#include "lvgl.h"
+#include "pixel_pack.h"
+#include "freertos/stream_buffer.h"
+#include "esp32c3/rom/tjpgd.h"
+#include "esp32c3/rom/miniz.h"
+
+//-----------------图片流式解码-----------------//
+// loop() 把 'n' 帧的数据推进字节流，解码任务边读边解，
+// 每解出 IMG_BAND_ROWS 行就转成 4bit 灰度（gamma + 有序抖动）写到面板缓存，只需要一条带的缓冲。
+// JPEG 用 ROM 里的 tjpgd，PNG 用 ROM 里 miniz 的 tinfl 解压，自己做行过滤还原。
+
+struct img_job
+{
+    uint8_t fmt;
+    int x, y, w, h;          // 逻辑坐标
+    uint32_t total;
+};
+
+static QueueHandle_t job_queue = NULL;
+static StreamBufferHandle_t img_stream = NULL;
+static StaticStreamBuffer_t img_stream_struct;
+static uint8_t img_stream_storage[IMG_STREAM_SIZE + 1];
+static uint32_t rx_remaining = 0;    // loop() 侧：本张图还要收的字节
+static uint32_t rd_remaining = 0;    // 解码任务侧：本张图还没读的字节
+
+// 统计
+static uint32_t spi_us = 0;
+static uint32_t spi_bytes = 0;
+static volatile uint32_t img_done = 0;           // 下面三个是所有图片的累计，image_perf() 读
+static uint32_t img_spi_us = 0;
+static uint32_t img_spi_bytes = 0;
+
+//------------------------------写屏------------------------------//
+static inline u8 gray8(u8 r, u8 g, u8 b)
+{
+    return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+// 当前这一条带：逻辑 y 从 band_y0 开始的 IMG_BAND_ROWS 行，旋转后是每个面板行（逻辑 x）上连续的 IMG_BAND_ROWS 个物理列，
+// 物理方向存，写屏时一行一个 spi_wr_cache_end。band_y0 是 8 的倍数，带正好盖住整数个面板的 8 列块。
+static u8 band[PANEL_HEIGHT][IMG_BAND_ROWS / 2];
+static int band_y0 = 0;
+
+// 开始新的一条带
+static void img_band_begin(int y0)
+{
+    band_y0 = y0;
+    memset(band, 0, sizeof(band));
+}
+
+// 和 my_disp_flush 一样按 LV_DISP_ROT_270，逻辑 (x, y) 对应物理 (479 - y, x)
+// luma 是 8 位亮度，在这里做 gamma 和有序抖动成 4bit（抖动矩阵按逻辑坐标取）
+static inline void img_put_pixel(int x, int y, u8 luma)
+{
+    int k = band_y0 + IMG_BAND_ROWS - 1 - y;     // 在带里的物理列
+    if ((unsigned)x >= PANEL_HEIGHT || (unsigned)k >= IMG_BAND_ROWS) {
+        return;
+    }
+    u8 gray = pixel_dither(luma, x, y);
+    pixel_set_nib(&band[x][k / 2], k, gray);     // k 和物理列奇偶相同
+}
+
+// 把当前带里逻辑 x0~x1、y 从 band_y0 到 y1 的部分写到面板缓存，调用者持有 panel_lock
+static void img_flush_band(int x0, int x1, int y1)
+{
+    if (x0 < 0) x0 = 0;
+    if (x1 >= PANEL_HEIGHT) x1 = PANEL_HEIGHT - 1;
+    if (y1 >= PANEL_WIDTH) y1 = PANEL_WIDTH - 1;
+    if (x0 > x1 || band_y0 > y1) {
+        return;
+    }
+    // 行数是奇数时物理列从奇数开始，写缓存得从前一列（图片下面那一行）开始。那一列是 8 列块的第一列时，
+    // 面板上的值在 col8 里，带上一起写；否则不知道面板上是什么（没接 MISO，spi_rd_cache 读不回来），
+    // 图片最后一行不写，少显示一行，不去改 LVGL 画的东西
+    bool pad = false;
+    if ((y1 - band_y0) % 2 == 0) {
+        if (((PANEL_WIDTH - 2 - y1) & 7) == 0) {
+            pad = true;
+            y1++;
+        } else if (--y1 < band_y0) {
+            return;
+        }
+    }
+    int c0 = PANEL_WIDTH - 1 - y1;               // 物理列范围
+    int c1 = PANEL_WIDTH - 1 - band_y0;          // 8 的倍数减 1，后面多改写的像素是下一块的第一列
+    int k0 = band_y0 + IMG_BAND_ROWS - 1 - y1;   // c0 在带里的位置，偶数
+    u32 len = (c1 - c0 + 1) / 2;
+    u32 t0 = micros();
+    panel_sync_wait();                           // 上一次 SYNC 可能还没做完
+    for (int row = x0; row <= x1; row++) {
+        u8 *p = band[row] + k0 / 2;
+        if (pad) {
+            pixel_set_nib(p, 0, col8_get(row, c0));
+        }
+        for (int c = (c0 + 7) & ~7; c <= c1; c += 8) {
+            int k = c - c0 + k0;
+            col8_set(row, c, pixel_nib(band[row][k / 2], k));
+        }
+        spi_wr_cache_end(c0, row, p, len, pixel_pair(col8_get(row, c1 + 1), 0));
+    }
+    row_sig_reset(x0, x1);                       // 这些行面板上不再是 LVGL 上次写的内容
+    spi_us += micros() - t0;
+    spi_bytes += (x1 - x0 + 1) * (len + 6);
+}
+
+//------------------------------读数据------------------------------//
+// 解码任务读图片数据，buf 为 NULL 时跳过；返回实际读到的字节数，超时或读完返回的会比 n 少
+static uint32_t img_read(uint8_t *buf, uint32_t n)
+{
+    static uint8_t skip[64];
+    uint32_t got = 0;
+    if (n > rd_remaining) {
+        n = rd_remaining;
+    }
+    while (got < n) {
+        uint8_t *dst = buf ? buf + got : skip;
+        uint32_t want = buf ? n - got : min(n - got, (uint32_t)sizeof(skip));
+        size_t r = xStreamBufferReceive(img_stream, dst, want, pdMS_TO_TICKS(IMG_READ_TIMEOUT_MS));
+        if (r == 0) {
+            Serial.printf("图片数据超时，还差 %lu 字节\n", (unsigned long)rd_remaining);
+            rd_remaining = 0;
+            break;
+        }
+        got += r;
+        rd_remaining -= r;
+    }
+    return got;
+}
+
+static uint32_t img_read_be32()
+{
+    uint8_t b[4] = {0};
+    img_read(b, 4);
+    return (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+}
+
+//------------------------------RGB565------------------------------//
+static bool rgb565_decode(img_job *job)
+{
+    static uint8_t line[PANEL_WIDTH * 2];
+    if (job->w <= 0 || job->w > PANEL_WIDTH || job->h <= 0) {
+        return false;
+    }
+    for (int y = 0; y < job->h; y++) {
+        if (img_read(line, job->w * 2) != (uint32_t)job->w * 2) {
+            return false;
+        }
+        for (int x = 0; x < job->w; x++) {
+            uint16_t c = line[x * 2] << 8 | line[x * 2 + 1];
+            img_put_pixel(job->x + x, job->y + y, gray8((c >> 8) & 0xF8, (c >> 3) & 0xFC, (c << 3) & 0xF8));
+        }
+        if ((y + 1) % IMG_BAND_ROWS == 0 || y == job->h - 1) {
+            xSemaphoreTake(panel_lock, portMAX_DELAY);
+            img_flush_band(job->x, job->x + job->w - 1, job->y + y);
+            xSemaphoreGive(panel_lock);
+            img_band_begin(job->y + y + 1);
+        }
+    }
+    return true;
+}
+
+//------------------------------JPEG------------------------------//
+static UINT jpeg_in(JDEC *jd, BYTE *buf, UINT n)
+{
+    return img_read(buf, n);
+}
+
+// tjpgd 每解出一个 MCU 块（8x8 或 16x16，缩小时按比例变小，RGB888）调用一次，从左到右一排一排出；
+// MCU 的高度整除 IMG_BAND_ROWS，一排的最后一块填满一条带（或者到了图片底部）时写屏
+static UINT jpeg_out(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    img_job *job = (img_job *)jd->device;
+    const BYTE *rgb = (const BYTE *)bitmap;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        for (int x = rect->left; x <= rect->right; x++, rgb += 3) {
+            img_put_pixel(job->x + x, job->y + y, gray8(rgb[0], rgb[1], rgb[2]));
+        }
+    }
+    if (rect->right == job->w - 1 && ((rect->bottom + 1) % IMG_BAND_ROWS == 0 || rect->bottom == job->h - 1)) {
+        xSemaphoreTake(panel_lock, portMAX_DELAY);
+        img_flush_band(job->x, job->x + job->w - 1, job->y + rect->bottom);
+        xSemaphoreGive(panel_lock);
+        img_band_begin(job->y + rect->bottom + 1);
+    }
+    return 1;
+}
+
+static bool jpeg_decode(img_job *job)
+{
+    static BYTE pool[3100];              // tjpgd 工作区
+    JDEC jd;
+    JRESULT res = jd_prepare(&jd, jpeg_in, pool, sizeof(pool), job);
+    if (res != JDR_OK) {
+        Serial.printf("jpeg 头解析失败: %d\n", res);
+        return false;
+    }
+    // 放不下就用 tjpgd 自带的 1/2、1/4、1/8 缩小
+    BYTE scale = 0;
+    while (scale < 3 && ((int)(jd.width >> scale) > PANEL_HEIGHT - job->x || (int)(jd.height >> scale) > PANEL_WIDTH - job->y)) {
+        scale++;
+    }
+    job->w = jd.width >> scale;
+    job->h = jd.height >> scale;
+    res = jd_decomp(&jd, jpeg_out, scale);
+    if (res != JDR_OK) {
+        Serial.printf("jpeg 解码失败: %d\n", res);
+        return false;
+    }
+    return true;
+}
+
+//------------------------------PNG------------------------------//
+// 8 bit 深度：0 灰度、2 RGB、3 调色板、4 灰度+alpha、6 RGBA；alpha 按黑底混合（黑色就是不亮）
+struct png_state
+{
+    tinfl_decompressor inflator;
+    uint8_t dict[TINFL_LZ_DICT_SIZE];    // tinfl 流式解压需要整个 32K 窗口
+    size_t dict_ofs;
+    uint8_t rows[2][PANEL_WIDTH * 4 + 1];
+    uint8_t *cur, *prev;
+    uint32_t row_bytes;                  // 含开头的过滤类型字节
+    uint32_t row_pos;
+    int y;
+    uint8_t ctype, bpp;
+    uint8_t palette[256];                // 调色板已经换算成灰度
+};
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+static void png_unfilter(png_state *st)
+{
+    uint8_t *x = st->cur + 1;
+    const uint8_t *p = st->prev + 1;
+    uint32_t n = st->row_bytes - 1;
+    uint8_t bpp = st->bpp;
+    switch (st->cur[0]) {
+    case 1:
+        for (uint32_t i = bpp; i < n; i++) x[i] += x[i - bpp];
+        break;
+    case 2:
+        for (uint32_t i = 0; i < n; i++) x[i] += p[i];
+        break;
+    case 3:
+        for (uint32_t i = 0; i < n; i++) x[i] += ((i >= bpp ? x[i - bpp] : 0) + p[i]) >> 1;
+        break;
+    case 4:
+        for (uint32_t i = 0; i < n; i++) x[i] += paeth(i >= bpp ? x[i - bpp] : 0, p[i], i >= bpp ? p[i - bpp] : 0);
+        break;
+    default:
+        break;
+    }
+}
+
+static void png_output_row(png_state *st, img_job *job)
+{
+    const uint8_t *s = st->cur + 1;
+    for (int x = 0; x < job->w; x++, s += st->bpp) {
+        u8 g;
+        switch (st->ctype) {
+        case 0:  g = s[0]; break;
+        case 2:  g = gray8(s[0], s[1], s[2]); break;
+        case 3:  g = st->palette[s[0]]; break;
+        case 4:  g = (s[0] * s[1]) / 255; break;
+        default: g = (gray8(s[0], s[1], s[2]) * s[3]) / 255; break;
+        }
+        img_put_pixel(job->x + x, job->y + st->y, g);
+    }
+    if ((st->y + 1) % IMG_BAND_ROWS == 0 || st->y == job->h - 1) {
+        xSemaphoreTake(panel_lock, portMAX_DELAY);
+        img_flush_band(job->x, job->x + job->w - 1, job->y + st->y);
+        xSemaphoreGive(panel_lock);
+        img_band_begin(job->y + st->y + 1);
+    }
+}
+
+// 解压出来的字节拼成行，每凑满一行就还原过滤、输出
+static void png_rows(png_state *st, img_job *job, const uint8_t *data, size_t n)
+{
+    while (n > 0 && st->y < job->h) {
+        size_t k = st->row_bytes - st->row_pos;
+        if (k > n) k = n;
+        memcpy(st->cur + st->row_pos, data, k);
+        st->row_pos += k;
+        data += k;
+        n -= k;
+        if (st->row_pos == st->row_bytes) {
+            png_unfilter(st);
+            png_output_row(st, job);
+            uint8_t *t = st->prev;
+            st->prev = st->cur;
+            st->cur = t;
+            st->row_pos = 0;
+            st->y++;
+        }
+    }
+}
+
+// 喂一段 IDAT 数据给 tinfl，返回 false 表示解压出错
+static bool png_inflate(png_state *st, img_job *job, const uint8_t *in, size_t in_len)
+{
+    for (;;) {
+        size_t in_bytes = in_len;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - st->dict_ofs;
+        tinfl_status status = tinfl_decompress(&st->inflator, in, &in_bytes, st->dict, st->dict + st->dict_ofs, &out_bytes,
+                                               TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+        in += in_bytes;
+        in_len -= in_bytes;
+        png_rows(st, job, st->dict + st->dict_ofs, out_bytes);
+        st->dict_ofs = (st->dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+        if (status < TINFL_STATUS_DONE) {
+            Serial.printf("png 解压失败: %d\n", status);
+            return false;
+        }
+        if (status == TINFL_STATUS_DONE || (status == TINFL_STATUS_NEEDS_MORE_INPUT && in_len == 0)) {
+            return true;
+        }
+    }
+}
+
+static bool png_decode(img_job *job)
+{
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    static const uint8_t bpp_of[7] = {1, 0, 3, 1, 2, 0, 4};
+    uint8_t buf[256];
+    if (img_read(buf, 8) != 8 || memcmp(buf, sig, 8) != 0) {
+        Serial.printf("不是 png\n");
+        return false;
+    }
+    // 解压窗口 32K 加上 tinfl 的表大约 43K，只在解 PNG 时临时申请
+    png_state *st = (png_state *)malloc(sizeof(png_state));
+    if (st == NULL) {
+        Serial.printf("png 内存不足\n");
+        return false;
+    }
+    tinfl_init(&st->inflator);
+    st->dict_ofs = 0;
+    st->row_bytes = 0;                           // 0 表示还没收到有效的 IHDR
+    st->row_pos = 0;
+    st->y = 0;
+    st->cur = st->rows[0];
+    st->prev = st->rows[1];
+    memset(st->palette, 0, sizeof(st->palette)); // PLTE 没发全的索引显示成黑色
+    bool ok = false;
+    for (;;) {
+        uint32_t len = img_read_be32();
+        uint8_t type[4];
+        if (img_read(type, 4) != 4) {
+            break;
+        }
+        if ((memcmp(type, "IDAT", 4) == 0 || memcmp(type, "PLTE", 4) == 0) && st->row_bytes == 0) {
+            Serial.printf("png 块顺序错误: IHDR 之前出现 %.4s\n", (const char *)type);
+            break;                                   // row_bytes 还没定，不能往行缓冲里拷
+        }
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (len != 13 || st->row_bytes != 0 || img_read(buf, 13) != 13) break;   // IHDR 只能有一个
+            job->w = buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
+            job->h = buf[4] << 24 | buf[5] << 16 | buf[6] << 8 | buf[7];
+            st->ctype = buf[9];
+            if (buf[8] != 8 || buf[12] != 0 || st->ctype > 6 || bpp_of[st->ctype] == 0 ||
+                job->w <= 0 || job->w > PANEL_WIDTH || job->h <= 0) {
+                Serial.printf("不支持的 png: %dx%d depth %d type %d interlace %d\n", job->w, job->h, buf[8], buf[9], buf[12]);
+                break;
+            }
+            st->bpp = bpp_of[st->ctype];
+            st->row_bytes = job->w * st->bpp + 1;
+            memset(st->prev, 0, st->row_bytes);
+            img_read(NULL, 4);                       // CRC 不检查，链路已经有 CRC 了
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            for (uint32_t i = 0; i < len / 3 && i < 256; i++) {
+                img_read(buf, 3);
+                st->palette[i] = gray8(buf[0], buf[1], buf[2]);
+            }
+            img_read(NULL, len - (len / 3 < 256 ? len / 3 : 256) * 3 + 4);
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            while (len > 0) {
+                uint32_t n = img_read(buf, len < sizeof(buf) ? len : sizeof(buf));
+                if (n == 0 || !png_inflate(st, job, buf, n)) {
+                    len = 1;
+                    break;
+                }
+                len -= n;
+            }
+            if (len) break;
+            img_read(NULL, 4);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            ok = st->y == job->h;
+            break;
+        } else {
+            img_read(NULL, len + 4);                 // 其他块跳过
+        }
+    }
+    free(st);
+    return ok;
+}
+
+//------------------------------解码任务------------------------------//
+static void img_task(void *arg)
+{
+    img_job job;
+    for (;;) {
+        xQueueReceive(job_queue, &job, portMAX_DELAY);
+        rd_remaining = job.total;
+        spi_us = 0;
+        spi_bytes = 0;
+        img_band_begin(job.y);
+        u32 t0 = millis();
+        bool ok;
+        switch (job.fmt) {
+        case AR_LINK_IMG_RGB565: ok = rgb565_decode(&job); break;
+        case AR_LINK_IMG_JPEG:   ok = jpeg_decode(&job);   break;
+        case AR_LINK_IMG_PNG:    ok = png_decode(&job);    break;
+        default:                 ok = false;               break;
+        }
+        img_read(NULL, rd_remaining);                    // 出错时把这张图剩下的数据读掉
+        xSemaphoreTake(panel_lock, portMAX_DELAY);
+        panel_sync();
+        xSemaphoreGive(panel_lock);
+        img_spi_us += spi_us;
+        img_spi_bytes += spi_bytes;
+        img_done++;
+        Serial.printf("图片 fmt %d %dx%d %s: 解码+写屏 %lu ms, 其中 SPI %lu ms / %lu 字节\n",
+                      job.fmt, job.w, job.h, ok ? "完成" : "失败", (unsigned long)(millis() - t0),
+                      (unsigned long)(spi_us / 1000), (unsigned long)spi_bytes);
+    }
+}
+
+void my_image_init()
+{
+    job_queue = xQueueCreate(2, sizeof(img_job));
+    img_stream = xStreamBufferCreateStatic(IMG_STREAM_SIZE, 1, img_stream_storage, &img_stream_struct);
+    // tjpgd 和 tinfl 都比较吃栈
+    xTaskCreate(img_task, "img_decode", 1024 * 6, NULL, 3, NULL);
+}
+
+void image_perf(uint32_t *done, uint32_t *spi_us_total, uint32_t *spi_bytes_total)
+{
+    *spi_us_total = img_spi_us;
+    *spi_bytes_total = img_spi_bytes;
+    *done = img_done;
+}
+
+void image_begin(const uint8_t *hdr, size_t len)
+{
+    if (len < AR_LINK_IMG_HDR_LEN) {
+        return;
+    }
+    img_job job;
+    job.fmt = hdr[0];
+    job.x = ar_link::get_u16(hdr + 1);
+    job.y = ar_link::get_u16(hdr + 3) & ~7;          // 旋转后 y 对应物理列，带要对齐面板的 8 列块
+    job.w = ar_link::get_u16(hdr + 5);
+    job.h = ar_link::get_u16(hdr + 7);
+    job.total = ar_link::get_u32(hdr + 9);
+    Serial.printf("接收到图片: fmt %d, %lu 字节\n", job.fmt, (unsigned long)job.total);
+    if (rx_remaining > 0) {
+        Serial.printf("上一张图还差 %lu 字节没收到\n", (unsigned long)rx_remaining);
+    }
+    if (job.fmt == AR_LINK_IMG_CLEAR) {
+        rx_remaining = 0;
+        lv_obj_invalidate(lv_scr_act());                 // 整屏重绘，盖掉面板上的图片
+        return;
+    }
+    rx_remaining = job.total;
+    xQueueSend(job_queue, &job, portMAX_DELAY);
+}
+
+void image_data(const uint8_t *data, size_t len)
+{
+    if (len > rx_remaining) {
+        len = rx_remaining;                              // 没有 'm' 或者超出总长度的部分丢掉
+    }
+    rx_remaining -= len;
+    while (len > 0) {
+        // 流缓冲满了就等解码任务，S3 那边靠信用窗口停下来
+        size_t n = xStreamBufferSend(img_stream, data, len, pdMS_TO_TICKS(IMG_READ_TIMEOUT_MS));
+        if (n == 0) {
+            Serial.printf("图片解码卡住，丢弃 %u 字节\n", (unsigned)len);
+            break;
+        }
+        data += n;
+        len -= n;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "Arduino.h"
+#include "hal_driver.h"
+#include "ar_link.h"
+
+#define IMG_STREAM_SIZE     4096   // loop() -> 解码任务的字节流缓冲
+#define IMG_READ_TIMEOUT_MS 1000   // 解码任务等数据的超时，S3 中途不发了就放弃这张图
+#define IMG_BAND_ROWS       16     // 每解出这么多行写一次屏，要是 8 的倍数（面板按 8 列一块，见 myoled.h 的块首列）
+
+u8 col8_get(int row, int col);        // myoled.h，写缓存末尾多改写的那个像素在面板上的灰度
+void col8_set(int row, int col, u8 nib);
+extern SemaphoreHandle_t panel_lock;  // myoled.h
+void row_sig_reset(int y0, int y1);   // myoled.h，直接写过面板的行要清掉刷屏的行签名
+
+void my_image_init();
+// 在 loop() 里由 process_data() 调用
+void image_begin(const uint8_t *hdr, size_t len);   // 'm'
+void image_data(const uint8_t *data, size_t len);   // 'n'
+// 解码任务的累计：写完（或失败）的图片数、写屏的 SPI 时间（us）和字节数，基准测试用
+void image_perf(uint32_t *done, uint32_t *spi_us, uint32_t *spi_bytes);
@@ -0,0 +1,166 @@
+#include "my_thermal.h"
+#include "jbd013_api.h"
+#include "lvgl.h"
+#include "my_uart.h"
+
+//-----------------面板温控-----------------//
+// 面板原来一直按最大电流（wr_cur_reg(63)）点亮，不管温度。这里在 loop() 空闲时每 THERMAL_PERIOD_MS 采一个温度传感器，
+// 按最热的传感器调亮度和电流：不热的时候按温度稍微加亮度，保持看到的亮度不变；超过门限一档一档降，带回差。
+// 采样只在没有待刷新区域、帧环为空、DMA 队列发完、图片任务没占着面板的时候做，
+// 读的过程中每段之前看一眼帧环，来了帧就放弃这次采样，所以刷屏最多晚一段（TEMP_CHUNK 字节）的时间。
+// THERMAL_THROTTLE 为 0 时只采样和上报，不动寄存器。
+
+struct thermal_step
+{
+    int16_t hot_c;                // 最热的传感器到这个温度进这一档
+    uint8_t lum_pct;              // 亮度寄存器占目标亮度的百分比
+    uint8_t cur;                  // 电流寄存器（0~63）
+};
+
+static const thermal_step steps[] = {
+    {0, 100, 63},                 // 不降，和 panel_init 一样
+    {50, 75, 63},
+    {60, 50, 48},
+    {70, 25, 32},
+};
+#define STEP_COUNT (int)(sizeof(steps) / sizeof(steps[0]))
+
+static int16_t temps[THERMAL_SENSORS];        // 各传感器最近一次的温度，0.1 ℃
+static uint8_t next_sensor = 0;
+static uint32_t sample_ms = 0;                // 上一次采完的时间
+static int level = 0;
+static u16 lum_target = 0;                    // 初始化时面板的亮度寄存器
+static u16 lum_now = 0;
+static u8 cur_now = 63;
+
+// 上一次上报的内容
+static int16_t report_temp = AR_THERMAL_NONE;
+static uint32_t report_ms = 0;
+static bool report_dirty = true;
+
+static u8 thermal_abort(void)
+{
+    return my_uart_pending();
+}
+
+static int16_t hottest()
+{
+    int16_t t = AR_THERMAL_NONE;
+    for (int i = 0; i < THERMAL_SENSORS; i++) {
+        if (temps[i] != AR_THERMAL_NONE && (t == AR_THERMAL_NONE || temps[i] > t)) {
+            t = temps[i];
+        }
+    }
+    return t;
+}
+
+// 这一档、这个温度下应该写的亮度寄存器
+static u16 lum_for(int16_t t)
+{
+    u32 lum = lum_target;
+    if (level == 0 && t != AR_THERMAL_NONE && t > THERMAL_REF_C * 10) {
+        lum += lum * THERMAL_COMP_PCT * (t - THERMAL_REF_C * 10) / 10000;
+        u32 limit = lum_target > THERMAL_LUM_LIMIT ? lum_target : THERMAL_LUM_LIMIT;
+        if (lum > limit) {
+            lum = limit;
+        }
+    }
+    return lum * steps[level].lum_pct / 100;
+}
+
+// 写亮度和电流寄存器，和 panel_init 一样发一次 SYNC 生效；调用者持有 panel_lock
+static void thermal_apply(u16 lum, u8 cur)
+{
+    panel_sync_wait();
+    if (lum != lum_now) {
+        wr_lum_reg(lum);
+        lum_now = lum;
+    }
+    if (cur != cur_now) {
+        wr_cur_reg(cur);
+        cur_now = cur;
+    }
+    panel_sync();
+    report_dirty = true;
+}
+
+static void thermal_report(int16_t t)
+{
+    uint32_t now = millis();
+    bool temp_moved = t != AR_THERMAL_NONE && (report_temp == AR_THERMAL_NONE || abs(t - report_temp) >= 10);
+    if (!report_dirty && !temp_moved && now - report_ms < AR_LINK_THERMAL_MS) {
+        return;
+    }
+    uint8_t msg[AR_LINK_THERMAL_LEN];
+    ar_link::put_u16(msg, (uint16_t)t);
+    ar_link::put_u16(msg + 2, lum_now);
+    msg[4] = cur_now;
+    msg[5] = level;
+    send_hex(AR_LINK_THERMAL, (char *)msg, sizeof(msg));
+    report_temp = t;
+    report_ms = now;
+    report_dirty = false;
+}
+
+void thermal_poll()
+{
+    if (millis() - sample_ms < THERMAL_PERIOD_MS) {
+        return;
+    }
+    if (lv_disp_get_default()->inv_p != 0 || my_uart_pending() || !spi_dma_idle()) {
+        return;                                   // 有事要做，下一轮再采
+    }
+    if (xSemaphoreTake(panel_lock, 0) != pdTRUE) {
+        return;                                   // 图片任务在写屏
+    }
+    u32 t0 = micros();
+    u16 raw = rd_temperature_raw(next_sensor, thermal_abort);
+    u32 read_us = micros() - t0;
+    if (raw == TEMP_NONE && my_uart_pending()) {
+        xSemaphoreGive(panel_lock);               // 来帧让路，这次不算
+        return;
+    }
+    float c = raw == TEMP_NONE ? NAN : TEMP_RAW_TO_C(raw);
+    temps[next_sensor] = (c > -40 && c < 150) ? (int16_t)lroundf(c * 10) : AR_THERMAL_NONE;   // 读不到或者明显读错
+    next_sensor = (next_sensor + 1) % THERMAL_SENSORS;
+    sample_ms = millis();
+
+    int16_t t = hottest();
+    int old_level = level;
+    if (THERMAL_THROTTLE && t != AR_THERMAL_NONE) {
+        while (level + 1 < STEP_COUNT && t >= steps[level + 1].hot_c * 10) {
+            level++;
+        }
+        while (level > 0 && t < (steps[level].hot_c - THERMAL_HYST_C) * 10) {
+            level--;
+        }
+    }
+    u16 lum = lum_for(t);
+    u16 diff = lum > lum_now ? lum - lum_now : lum_now - lum;
+    if (THERMAL_THROTTLE && (level != old_level || steps[level].cur != cur_now || diff > lum_now / THERMAL_LUM_STEP)) {
+        thermal_apply(lum, steps[level].cur);
+    }
+    xSemaphoreGive(panel_lock);
+
+    if (level != old_level) {
+        Serial.printf("温控: %d.%d ℃, 档位 %d -> %d, 亮度 %u, 电流 %u (采样 %u us)\n", t / 10, abs(t % 10), old_level, level,
+                      lum_now, cur_now, read_us);
+    }
+    thermal_report(t);
+}
+
+void my_thermal_init()
+{
+    for (int i = 0; i < THERMAL_SENSORS; i++) {
+        temps[i] = AR_THERMAL_NONE;
+    }
+    xSemaphoreTake(panel_lock, portMAX_DELAY);
+    lum_target = rd_lum_reg();
+    xSemaphoreGive(panel_lock);
+    lum_now = lum_target;
+    if (lum_target == 0 || lum_target == 0xffff) {
+        lum_target = THERMAL_LUM_LIMIT;           // 没读到，按任何刷新率都合法的值，第一次采样时写进去
+        lum_now = 0;
+    }
+    Serial.printf("温控: 目标亮度 %u, 电流 %u\n", lum_target, cur_now);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "Arduino.h"
+#include "hal_driver.h"
+#include "ar_link.h"
+
+#define THERMAL_THROTTLE   0       // 1: 按温度改亮度和电流寄存器。温度解析还没和面板的实际读数对过，对过再打开；0 时只采样、上报
+#define THERMAL_PERIOD_MS  2000    // 每隔这么久采一个温度传感器，面板上 4 个轮流采
+#define THERMAL_SENSORS    4
+#define THERMAL_HYST_C     5       // 降档以后温度要比这一档的门限低这么多才升回去
+#define THERMAL_REF_C      30      // 这个温度以下不做亮度补偿
+#define THERMAL_COMP_PCT   4       // 每高 10 ℃ 亮度寄存器加这么多百分比，抵消发热后的光效下降（估计值，按实测改）
+#define THERMAL_LUM_LIMIT  2558    // 补偿最多加到这里：200Hz 自刷新的上限，哪个刷新率下都合法（见 wr_lum_reg）
+#define THERMAL_LUM_STEP   32      // 补偿值变化不到 1/32 不重写寄存器，温度抖一下不跟着改
+
+extern SemaphoreHandle_t panel_lock;  // myoled.h
+
+// bsp_lvgl_init() 之后调用，记下面板当前的亮度寄存器作为目标亮度
+void my_thermal_init();
+// 在 loop() 里每一轮调用，到时间了并且没有别的事才采样
+void thermal_poll();
@@ -1,173 +1,448 @@
 #include "my_uart.h"
 #include "Arduino.h"
+#include "driver/uart.h"
+#include "esp_sleep.h"
+#include "esp_pm.h"
 #include "generated/gui_guider.h"
+#include "my_image.h"
+#include "my_dlist.h"
+#include "my_glyph.h"
+#include "my_bench.h"
+#include "ar_link_stats.h"
 extern lv_ui guider_ui;
 
+static ar_link::Parser<LINK_FRAME_MAX> rx_parser;   // 长度字段超过 LINK_FRAME_MAX 的直接当坏帧
+static uint8_t tx_seq = 0;
+static SemaphoreHandle_t tx_lock = NULL;
+static QueueHandle_t uart_queue = NULL;    // UART 驱动的事件队列
+static TaskHandle_t render_task = NULL;    // loop() 所在的任务，帧进了帧环就叫醒它
+
+static uint32_t link_baud = AR_LINK_BAUD_DEFAULT;
+static uint32_t probation_ms = 0;          // 切换波特率的时间，在这之后还没收到好帧就退回，0 表示不在试用期
+static uint32_t garbage_ms = 0;            // 非默认波特率下开始收到乱码的时间
+static esp_pm_lock_handle_t rx_pm_lock = NULL;   // 收到数据后拿着，LINK_RX_AWAKE_MS 内不进浅睡眠；NULL 表示没有电源管理
+static bool rx_awake = false;              // 正拿着 rx_pm_lock
+static uint32_t rx_awake_ms = 0;           // 最后一次收到数据的时间
+
+// 接收任务和 loop() 都会改，计数偶尔少一次无所谓，不加锁
+static ar_link::LinkStats link_stats;
+
 //---------------------------------发送--------------------------------------//
-// 发送数据的底层函数
+// 发送数据的底层函数，只拷贝进驱动的发送环形缓冲，不等发完
 void _my_send(char *data, int len) {
-    // 假设这里是用底层协议进行数据发送
-    // send(connect_socket, data, len, 0); // 通信底层发送
-    // 此处只做示例输出
-    printf("发送数据: %.*s\n", len, data); // 实际发送代码替换这里
-}
-
-// 创建数据结构
-struct My_tcpdata *create_data(char cmd, char *data0, int data_len) {
-    struct My_tcpdata *data = (My_tcpdata *)malloc(sizeof(struct My_tcpdata));
-    if (data == NULL) {
-        perror("Malloc failed");
-        return NULL;
+    if (len > 0) {
+        uart_write_bytes(LINK_UART, data, len);
     }
-    data->cmd = cmd;
-    data->data = data0;
-    data->data_len = data_len;
-    return data;
 }
 
 // 发送数据
-void my_send(struct My_tcpdata *data) {
-    char sendbuff[11];
-    sprintf(sendbuff, "%c%08d", data->cmd, data->data_len);
-    _my_send(sendbuff, strlen(sendbuff)); // 发送头
-    _my_send(data->data, data->data_len); // 发送内容
-    printf("发送成功: cmd:%c, data_len=%d\n", data->cmd, data->data_len);
-    free(data); // 释放数据结构内存
+void my_send(const struct My_tcpdata &data) {
+    char header[AR_LINK_HEADER_MAX];
+    // 接收任务（BAUD_ACK/PONG/统计）和 loop()（ACK/字形请求/温控/基准测试）都会发，序号要在锁里取，线上才是连续的
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    size_t hlen = ar_link::encode_header((uint8_t *)header, data.cmd, tx_seq++, data.data_len);
+    uint16_t crc = ar_link::frame_crc((uint8_t *)header, hlen, data.data, data.data_len);
+    char tail[AR_LINK_CRC_LEN] = {(char)crc, (char)(crc >> 8)};
+    _my_send(header, hlen);                        // 发送头
+    _my_send((char *)data.data, data.data_len);    // 发送内容
+    _my_send(tail, sizeof(tail));                  // 发送校验
+    xSemaphoreGive(tx_lock);
+    AR_STAT(ar_link::stats_count(link_stats.tx_frames, link_stats.tx_bytes, data.cmd, data.data_len));
+    LINK_LOG("发送成功: cmd:%c, data_len=%d\n", data.cmd, data.data_len);
 }
 
 // 发送字符串
-void send_string(char cmd, char *str) {
-    my_send(create_data(cmd, str, strlen(str)));
+void send_string(char cmd, const char *str) {
+    my_send({cmd, (int)strlen(str), str});
 }
 
 // 发送十六进制数据
 void send_hex(char cmd, char *buff, int len) {
-    my_send(create_data(cmd, buff, len));
+    my_send({cmd, len, buff});
 }
 //---------------------------------接收--------------------------------------//
 
-// 接收数据的底层函数
+// 接收数据的底层函数，不阻塞，返回实际读到的字节数
 int _my_receive(char *buffer, int buffer_len) {
-    return Serial1.readBytes(buffer, buffer_len);
-    // 假设这里是用底层协议进行数据接收
-    // return recv(connect_socket, buffer, buffer_len, 0); // 实际接收代码替换这里
-    // 此处只做示例模拟数据接收
+    return uart_read_bytes(LINK_UART, (uint8_t *)buffer, buffer_len, 0);
 }
 
-// 准备接收数据
-struct My_tcpdata * receive_data() {
-    char header[9]; // cmd (1 byte) + data_len (8 bytes)
-    int bytes_received = _my_receive(header, sizeof(header));
+//--------------------------------帧环--------------------------------------//
+// 接收任务把解析好的帧写进固定大小的环形区，loop() 原地处理后再释放，全程不 malloc。
+// 单生产者单消费者，head 只由接收任务写，tail 只由 loop() 写，不需要加锁。
+// 每条记录：u16 长度 + u8 命令 + u8 序号 + u32 收到时间 + 数据 + '\0'，按 4 字节对齐；
+// 写到环尾放不下时写一个跳过标记，从头开始写。
+#define RING_HDR   8
+#define RING_SKIP  0xFFFF
 
-    if (bytes_received <= 0) {
-        perror("接收失败或者连接关闭");
-        return NULL;
-    }
+static uint8_t frame_ring[LINK_RING_SIZE] __attribute__((aligned(4)));
+static uint32_t ring_head = 0;             // 累计写入字节数
+static uint32_t ring_tail = 0;             // 累计释放字节数
+static uint32_t ring_drops = 0;            // 环满丢掉的帧数
 
-    // 解析命令和数据长度
-    char cmd = header[0];
-    int data_len = atoi(&header[1]); // 解析数据长度
+static inline uint32_t ring_record_len(size_t len)
+{
+    return (RING_HDR + len + 1 + 3) & ~3u;
+}
 
-    // 分配内存以接收数据
-    char *data = (char *)malloc(data_len);
-    if (data == NULL) {
-        perror("Malloc failed");
-        return NULL;
+// 接收任务调用，环满返回 false
+static bool ring_put(const ar_link::Frame &frame)
+{
+    uint32_t rec = ring_record_len(frame.len);
+    uint32_t head = ring_head;
+    uint32_t used = head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    uint32_t pos = head % LINK_RING_SIZE;
+    uint32_t pad = pos + rec > LINK_RING_SIZE ? LINK_RING_SIZE - pos : 0;
+    if (used + pad + rec > LINK_RING_SIZE) {
+        return false;
     }
-
-    // 接收数据
-    bytes_received = _my_receive(data, data_len);
-    if (bytes_received <= 0) {
-        free(data);
-        perror("接收数据失败");
-        return NULL;
+    if (pad) {
+        frame_ring[pos] = RING_SKIP & 0xff;
+        frame_ring[pos + 1] = RING_SKIP >> 8;
+        head += pad;
+        pos = 0;
     }
+    uint8_t *p = frame_ring + pos;
+    p[0] = (uint8_t)frame.len;
+    p[1] = (uint8_t)(frame.len >> 8);
+    p[2] = frame.type;
+    p[3] = frame.seq;
+    ar_link::put_u32(p + 4, micros());
+    memcpy(p + RING_HDR, frame.data, frame.len);
+    p[RING_HDR + frame.len] = '\0';      // 文本命令可以直接当 C 字符串用
+    __atomic_store_n(&ring_head, head + rec, __ATOMIC_RELEASE);
+    AR_STAT(ar_link::stats_high(&link_stats.queue_high, used + pad + rec));
+    return true;
+}
 
-    // 返回数据结构
-    struct My_tcpdata *received_data = (My_tcpdata *)malloc(sizeof(struct My_tcpdata));
-    if (received_data == NULL) {
-        free(data);
-        perror("Malloc failed");
-        return NULL;
+// loop() 调用，取出最早的一帧，data 指向环里的数据，处理完调用 ring_release()
+static bool ring_peek(struct My_tcpdata *out, uint8_t *seq, uint32_t *recv_us, uint32_t *rec)
+{
+    for (;;) {
+        uint32_t tail = ring_tail;
+        if (tail == __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        uint32_t pos = tail % LINK_RING_SIZE;
+        const uint8_t *p = frame_ring + pos;
+        uint16_t len = p[0] | (p[1] << 8);
+        if (len == RING_SKIP) {
+            __atomic_store_n(&ring_tail, tail + (LINK_RING_SIZE - pos), __ATOMIC_RELEASE);
+            continue;
+        }
+        out->cmd = p[2];
+        out->data_len = len;
+        out->data = (const char *)p + RING_HDR;
+        *seq = p[3];
+        *recv_us = ar_link::get_u32(p + 4);
+        *rec = ring_record_len(len);
+        return true;
     }
-    received_data->cmd = cmd;
-    received_data->data = data;
-    received_data->data_len = data_len;
+}
+
+static void ring_release(uint32_t rec)
+{
+    __atomic_store_n(&ring_tail, ring_tail + rec, __ATOMIC_RELEASE);
+}
 
-    return received_data;
+// loop() 调用：帧环里还有没处理的帧，温控采样用它让路
+bool my_uart_pending()
+{
+    return ring_tail != __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+}
+
+//--------------------------------ACK--------------------------------------//
+// 显示帧应用到 LVGL 之后先记下来，等这次改动真正刷到屏上再回 ACK，S3 凭 ACK 归还信用
+struct pending_ack
+{
+    uint8_t seq;
+    uint32_t recv_us;
+    uint32_t applied_us;
+};
+static pending_ack acks[AR_LINK_CREDITS * 2];
+static int ack_count = 0;
+
+static void send_ack(uint8_t seq, uint8_t flags, uint32_t queue_us, uint32_t render_us)
+{
+    uint8_t ack[AR_LINK_ACK_LEN];
+    ack[0] = seq;
+    ack[1] = flags;
+    ar_link::put_u32(ack + 2, queue_us);
+    ar_link::put_u32(ack + 6, render_us);
+    send_hex(AR_LINK_ACK, (char *)ack, sizeof(ack));
+}
+
+// 在 loop() 里 lv_timer_handler() 之后调用：没有待刷新的区域了，说明之前应用的帧都已经上屏
+void my_uart_ack_rendered()
+{
+    if (ack_count == 0 || lv_disp_get_default()->inv_p != 0) {
+        return;
+    }
+    uint32_t now = micros();
+    for (int i = 0; i < ack_count; i++) {
+        AR_STAT(ar_link::stats_hist(link_stats.transit, acks[i].applied_us - acks[i].recv_us));
+        AR_STAT(ar_link::stats_hist(link_stats.process, now - acks[i].applied_us));
+        send_ack(acks[i].seq, 0, acks[i].applied_us - acks[i].recv_us, now - acks[i].applied_us);
+    }
+    ack_count = 0;
 }
 
 // 处理接收到的数据
-void process_data(struct My_tcpdata *data) {
+void process_data(const struct My_tcpdata *data) {
     // 处理不同类型的数据
     switch (data->cmd) {
-        case 'a':
-            Serial.printf("接收到a字符串: %.*s\n", data->data_len, data->data);
+        case 'a': {
+            uint32_t t0 = micros();
+            dlist_off();
             lv_label_set_text_fmt(guider_ui.screen_label_1, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_1);
+            LINK_LOG("接收到a字符串: %.*s (应用 %lu us)\n", data->data_len, data->data, (unsigned long)(micros() - t0));
             break;
+        }
         case 'b':
-            Serial.printf("接收到b字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到b字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_2, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_2);
             break;
         case 'c':
-            Serial.printf("接收到c字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到c字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_4, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_4);
             break;
         case 'd':
-            Serial.printf("接收到d字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到d字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_5, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_5);
             break;
         case 'e':
-            Serial.printf("接收到e字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到e字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_6, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_6);
             break;
         case 'f': 
-            Serial.printf("接收到f字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到f字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_7, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_7);
             break;
         case 'g': 
-            Serial.printf("接收到g字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到g字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_8, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_8);
             break;
         case 'h': 
-            Serial.printf("接收到h字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到h字符串: %.*s\n", data->data_len, data->data);
             lv_label_set_text_fmt(guider_ui.screen_label_9, "%.*s",data->data_len,data->data);
             lv_obj_invalidate(guider_ui.screen_label_9);
             break;
         case 'i':
-            Serial.printf("接收到i字符串: %.*s\n", data->data_len, data->data);
+            LINK_LOG("接收到i字符串: %.*s\n", data->data_len, data->data);
+            dlist_off();
             lv_bar_set_value(guider_ui.screen_bar_1,atoi(data->data), LV_ANIM_OFF);
             lv_obj_invalidate(guider_ui.screen_bar_1);
             break;
+        case 'j':
+            dlist_off();
+            lv_label_set_text(guider_ui.screen_label_1, data->data);
+            break;
+        case 'k':
+            dlist_off();
+            lv_label_ins_text(guider_ui.screen_label_1, LV_LABEL_POS_LAST, data->data);
+            break;
+        case AR_LINK_IMG_BEGIN:
+            image_begin((const uint8_t *)data->data, data->data_len);
+            break;
+        case AR_LINK_IMG_DATA:
+            image_data((const uint8_t *)data->data, data->data_len);
+            break;
+        case AR_LINK_DLIST:
+            dlist_apply((const uint8_t *)data->data, data->data_len);
+            break;
+        case AR_LINK_GLYPH:
+            glyph_apply((const uint8_t *)data->data, data->data_len);
+            break;
+        case AR_LINK_GLYPH_SET:
+            glyph_prefetch((const uint8_t *)data->data, data->data_len);
+            break;
+        case AR_LINK_SCREEN: {
+            // 屏幕状态帧：逐个字段按单字段命令处理，都在 lv_timer_handler() 之前改完，只刷新一次
+            size_t pos = 0;
+            uint8_t tag;
+            const uint8_t *value;
+            size_t value_len;
+            while (ar_link::tlv_next((const uint8_t *)data->data, data->data_len, &pos, &tag, &value, &value_len)) {
+                if (tag == AR_LINK_SCREEN) {
+                    continue;
+                }
+                My_tcpdata field = {(char)tag, (int)value_len, (const char *)value};
+                process_data(&field);
+            }
+            break;
+        }
         // 添加其他命令类型的处理
         default:
             Serial.printf("未知的命令: %c\n", data->cmd);
             break;
     }
-    
-    // 记得释放接收到的数据内存
-    free(data->data);
-    free(data);
 }
 
+//--------------------------------链路控制------------------------------------//
+static void link_set_baud(uint32_t baud)
+{
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    uart_wait_tx_done(LINK_UART, pdMS_TO_TICKS(100));   // 应答要用旧波特率发完
+    uart_set_baudrate(LINK_UART, baud);
+    link_baud = baud;
+    xSemaphoreGive(tx_lock);
+    probation_ms = baud == AR_LINK_BAUD_DEFAULT ? 0 : millis();
+    garbage_ms = 0;
+}
+
+// 链路控制帧直接在接收任务里回复，不经过 loop()，这样测出来的往返时间不受刷屏影响
+static bool link_ctrl(const ar_link::Frame &frame)
+{
+    switch (frame.type) {
+    case AR_LINK_BAUD_REQ: {
+        if (frame.len < 4) return true;
+        uint32_t baud = ar_link::get_u32(frame.data);
+        if (!ar_link::baud_supported(baud)) {
+            Serial.printf("不支持的波特率: %lu\n", (unsigned long)baud);
+            return true;
+        }
+        send_hex(AR_LINK_BAUD_ACK, (char *)frame.data, 4);
+        link_set_baud(baud);
+        Serial.printf("波特率切换到 %lu\n", (unsigned long)baud);
+        return true;
+    }
+    case AR_LINK_PING:
+        send_hex(AR_LINK_PONG, (char *)frame.data, frame.len);
+        return true;
+    case AR_LINK_STATS_REQ: {
+        const ar_link::ParserStats &ps = rx_parser.stats();
+        link_stats.version = sizeof(link_stats);
+        link_stats.crc_errors = ps.crc_errors;
+        link_stats.len_errors = ps.len_errors;
+        link_stats.resyncs = ps.resyncs;
+        link_stats.skipped = ps.skipped;
+        link_stats.drops = ring_drops;
+        send_hex(AR_LINK_STATS_REPORT, (char *)&link_stats, sizeof(link_stats));
+        return true;
+    }
+    case AR_LINK_BENCH_REQ:
+        bench_request();                                    // 要动 LVGL，交给 loop()
+        xTaskNotifyGive(render_task);
+        return true;
+    default:
+        return frame.type >= 0x80;                          // 其他控制帧忽略
+    }
+}
+
+static void on_frame(const ar_link::Frame &frame)
+{
+      probation_ms = 0;                                     // 新波特率下收到好帧，转正
+      garbage_ms = 0;
+      AR_STAT(ar_link::stats_count(link_stats.rx_frames, link_stats.rx_bytes, frame.type, frame.len));
+      if (link_ctrl(frame)) {
+            return;
+      }
+      if (!ring_put(frame)) {
+            ring_drops++;
+            Serial.printf("接收帧环满，丢弃: cmd:%c, 累计 %lu\n", frame.type, (unsigned long)ring_drops);
+            send_ack(frame.seq, AR_LINK_ACK_DROPPED, 0, 0);     // 也要归还信用
+            return;
+      }
+      xTaskNotifyGive(render_task);
+}
+
+//--------------------------------接收任务------------------------------------//
+static void uart_rx_task(void *arg)
+{
+      uart_event_t event;
+      char buf[128];
+      for (;;) {
+            // 试用期或者收乱码期间带超时等待，好让它们在没有任何数据时也能到期；平时一直睡到有数据
+            TickType_t wait = (probation_ms || garbage_ms) ? pdMS_TO_TICKS(50) : portMAX_DELAY;
+            if (rx_awake) {
+                  wait = pdMS_TO_TICKS(LINK_RX_AWAKE_MS);   // 到时候放开浅睡眠
+            }
+            if (xQueueReceive(uart_queue, &event, wait)) {
+                  if (event.type == UART_DATA) {
+                        rx_awake_ms = millis();
+                        if (!rx_awake && rx_pm_lock) {
+                              esp_pm_lock_acquire(rx_pm_lock);
+                              rx_awake = true;
+                        }
+                        uint32_t frames = rx_parser.stats().frames;
+                        int n;
+                        while ((n = _my_receive(buf, sizeof(buf))) > 0) {
+                              rx_parser.feed((uint8_t *)buf, n, on_frame);
+                        }
+                        if (link_baud != AR_LINK_BAUD_DEFAULT && rx_parser.stats().frames == frames && garbage_ms == 0) {
+                              garbage_ms = millis();
+                        }
+                  } else if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+                        Serial.printf("uart rx overflow\n");
+                        uart_flush_input(LINK_UART);
+                        xQueueReset(uart_queue);
+                        rx_parser.reset();
+                  }
+            }
+            // 新波特率试用期内没收到好帧，或者一直只收到乱码，退回默认波特率等 S3 重新协商
+            if ((probation_ms && millis() - probation_ms > AR_LINK_PROBATION_MS) ||
+                (garbage_ms && millis() - garbage_ms > AR_LINK_GARBAGE_MS)) {
+                  Serial.printf("波特率 %lu 不可用，退回 %d\n", (unsigned long)link_baud, AR_LINK_BAUD_DEFAULT);
+                  link_set_baud(AR_LINK_BAUD_DEFAULT);
+                  rx_parser.reset();
+            }
+            if (rx_awake && millis() - rx_awake_ms >= LINK_RX_AWAKE_MS) {
+                  esp_pm_lock_release(rx_pm_lock);
+                  rx_awake = false;
+            }
+      }
+}
+
+// 在 loop() 里调用，处理接收任务收好的帧
 void onDataReceived()
 {
-      // 处理接收到的数据
-      while (Serial1.available())
-      {
-            My_tcpdata* data=receive_data();
-            process_data(data);
-            // 进行数据处理操作
+      My_tcpdata data;
+      uint8_t seq;
+      uint32_t recv_us, rec;
+      while (ring_peek(&data, &seq, &recv_us, &rec)) {
+            process_data(&data);
+            ring_release(rec);
+            if (ack_count == sizeof(acks) / sizeof(acks[0])) {
+                  my_uart_ack_rendered();                   // S3 不守信用窗口时才会走到这里
+                  if (ack_count == sizeof(acks) / sizeof(acks[0])) {
+                        send_ack(seq, 0, micros() - recv_us, 0);
+                        continue;
+                  }
+            }
+            acks[ack_count++] = {seq, recv_us, (uint32_t)micros()};
       }
 }
+
 void my_uart_init(){
-    Serial1.begin(115200,SERIAL_8N1,RX_PIN,TX_PIN);
-    // Serial1.onReceive(onDataReceived);
-}
\ No newline at end of file
+    uart_config_t config = {};
+    config.baud_rate = AR_LINK_BAUD_DEFAULT;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+    uart_driver_install(LINK_UART, LINK_RX_BUF, LINK_TX_BUF, 20, &uart_queue, 0);
+    uart_param_config(LINK_UART, &config);
+    uart_set_pin(LINK_UART, TX_PIN, RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_set_rx_timeout(LINK_UART, 2);                      // 线上空闲 2 个字符就上报
+    // 自动浅睡眠时靠 RX 上的边沿醒来，醒来前的几个字节会丢，S3 空闲后先发唤醒字节（见 ar_link.h）
+    uart_set_wakeup_threshold(LINK_UART, AR_LINK_WAKE_EDGES);
+    esp_sleep_enable_uart_wakeup(LINK_UART);
+    // 收到数据后醒着的锁（见 LINK_RX_AWAKE_MS），核心没开 CONFIG_PM_ENABLE 时建不出来，就不拿
+    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "link_rx", &rx_pm_lock) != ESP_OK) {
+        rx_pm_lock = NULL;
+    }
+
+    tx_lock = xSemaphoreCreateMutex();
+    render_task = xTaskGetCurrentTaskHandle();              // setup() 和 loop() 在同一个任务里
+    xTaskCreate(uart_rx_task, "uart_rx", 1024 * 4, NULL, 12, NULL);
+
+    send_hex(AR_LINK_HELLO, NULL, 0);                       // 告诉 S3 这边刚上电，需要重新协商
+}
@@ -1,27 +1,40 @@
 
 #pragma once
+#include "ar_link.h"
 #define TX_PIN 1
 #define RX_PIN 0
 
+#define LINK_UART        UART_NUM_1
+#define LINK_RX_BUF      4096     // 驱动接收环形缓冲，loop() 刷屏时也不会丢字节
+#define LINK_TX_BUF      1024
+#define LINK_FRAME_MAX   1024     // 单帧数据上限，超过的长度字段当坏帧丢掉
+// 接收任务交给 loop() 的帧环：S3 信用窗口内的最大帧，再加一个最大帧给环尾的跳过标记
+#define LINK_RING_SIZE   ((AR_LINK_CREDITS + 1) * (LINK_FRAME_MAX + 12))
+// 收到数据后至少这么久不进浅睡眠。S3 只在空闲超过 AR_LINK_WAKE_IDLE_MS 后才发唤醒字节，
+// 这段时间内紧跟着来的帧没有唤醒字节，C3 要醒着收
+#define LINK_RX_AWAKE_MS (AR_LINK_WAKE_IDLE_MS + 5)
+#define LINK_LOG_FRAMES 0         // 1: 每帧打印收发内容和 ACK，调协议时打开；平时关掉，图片分段和 ACK 会刷屏
+#define LINK_LOG(...)   do { if (LINK_LOG_FRAMES) Serial.printf(__VA_ARGS__); } while (0)
+
+// 一帧的视图，data 指向帧环或者调用者的缓冲，不拥有内存
 struct My_tcpdata
 {
     char cmd;
     int data_len;
-    char* data;
+    const char* data;    // 接收时以 '\0' 结尾
 };
 
 
-void send_string(char cmd,char *str);
+void send_string(char cmd,const char *str);
 void send_hex(char cmd,char *buff,int len);
-struct My_tcpdata *receive_data();
-void process_data(struct My_tcpdata *data);
+void process_data(const struct My_tcpdata *data);
 void my_uart_init();
 void onDataReceived();
+void my_uart_ack_rendered();
+bool my_uart_pending();
 
 //-----------------自定义通讯协议---------------------------//
-//cmd            1 byte          命令位
-//data_len       8 byte          长度位
-//data           data_len byte   数据位  
+//帧格式见 shared/ar_link/ar_link.h：同步字 + 命令 + 序号 + 长度 + 数据 + CRC16
 //---------------------命令表------------------------------//        
 //               a            string 字符串
 //               b            hex    文件
@@ -31,4 +44,17 @@ void onDataReceived();
 //               f            time   时间
 //               g            json   文本
 //               h            txt    文本
+//               j            live   实时文本，替换 screen_label_1
+//               k            live   实时文本，追加到 screen_label_1
+//               l            screen 屏幕状态，多个字段一帧（格式见 ar_link.h），翻页用
+//               m            image  图片开始：格式/位置/大小（RGB565、JPEG、PNG，见 ar_link.h）
+//               n            image  图片数据，交给解码任务边收边解边写屏
+//               o            dlist  显示列表：S3 排好版的文字行、矩形、进度条，C3 不经过 label 直接画（格式见 ar_link.h）
+//               p            glyph  S3 从 SD 字库取来的字形，放进字形缓存
+//               q            glyph  下一页要用的字，缺的先要过来
+//            0x80~           链路控制（HELLO / 波特率协商 / PING / 统计 / 基准测试请求），见 ar_link.h，在接收任务里直接处理
+//            0x85            ACK  显示帧渲染完后回给 S3，带序号和耗时，S3 凭它归还信用
+//            0x88            GLYPH_REQ  向 S3 要缺的字形
+//            0x89            THERMAL  面板温度、亮度、电流和降档级别，温控定时上报
+//            0x8B            BENCH_RESULT  显示基准测试一个场景的结果（S3 发 0x8A 要求跑一次，见 my_bench.cpp）
 
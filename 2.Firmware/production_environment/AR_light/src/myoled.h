@@ -3,33 +3,113 @@
 #include <SPI.h>
 #include <driver/spi_master.h>
 #include "lvgl.h"
+#include "my_dlist.h"
+#include "pixel_pack.h"
+#include "my_bench.h"
+#include "esp_pm.h"
 // #include "font_alipuhui20.h"
 
 
-#define PANEL_WIDTH  480
-#define PANEL_HEIGHT 480
-
 static lv_disp_draw_buf_t draw_buf;
 lv_obj_t *label;
 
+//-----------------启动时间线-----------------//
+// 从 app 启动（micros() 从 0 开始，不含 ROM 和二级引导）到第一帧的 SYNC 排出去，每一步记一个时间点，
+// 第一帧之后在 loop() 里一次打印，不在启动途中占串口。
+#define BOOT_MARK_MAX 16
+
+struct boot_mark_t
+{
+    const char *what;
+    u32 us;
+};
+static boot_mark_t boot_marks[BOOT_MARK_MAX];
+static int boot_mark_count = 0;
+static bool boot_first_frame = false;             // 第一帧已经刷出去
+static bool boot_reported = false;
+
+void boot_mark(const char *what)
+{
+    if (boot_mark_count < BOOT_MARK_MAX) {
+        boot_marks[boot_mark_count++] = {what, (u32)micros()};
+    }
+}
+
+void boot_report()
+{
+    if (!boot_first_frame || boot_reported) {
+        return;
+    }
+    boot_reported = true;
+    u32 prev = 0;
+    for (int i = 0; i < boot_mark_count; i++) {
+        Serial.printf("启动 %6u us (+%6u us): %s\n", boot_marks[i].us, boot_marks[i].us - prev, boot_marks[i].what);
+        prev = boot_marks[i].us;
+    }
+}
+
+//-----------------行签名-----------------//
+// 每一行上次写到面板的列范围和这段像素的散列。LVGL 的脏区域里常有打包出来和面板上一模一样的行
+// （进度条只动了一格、时钟没变的那几位数字），范围和散列都一样就整行不发。
+// 图片解码直接写面板，写过的行要 row_sig_reset()，下一次 LVGL 重绘时照常写。
+struct row_sig
+{
+    u16 x1, x2;                                   // 物理列范围，x1 = 0xFFFF 表示不知道面板上是什么
+    u32 hash;
+};
+static row_sig row_sigs[PANEL_HEIGHT];
+
+// 调用者持有 panel_lock（初始化时除外）
+void row_sig_reset(int y0, int y1)
+{
+    for (int y = y0; y <= y1; y++) {
+        row_sigs[y].x1 = 0xFFFF;
+    }
+}
+
+//-----------------块首列-----------------//
+// 不再留整屏的帧缓冲（原来的 g_fb 有 115200 字节）。刷屏的区域由 my_rounder 对齐到物理 8 列，
+// 4bit 写入的末尾会多改写一个像素，它一定是下一个 8 列块的第一列，
+// 所以只记每行每个 8 列块第一列在面板上的灰度（每行 60 个像素，两个一字节），写的时候从这里带上。
+// 刷屏和图片写面板时都要更新，调用者持有 panel_lock。
+static u8 col8[PANEL_HEIGHT * PANEL_WIDTH / 16];
+
+// col 是 8 的倍数；可见区域右边（col == PANEL_WIDTH）写什么都看不见，返回 0
+u8 col8_get(int row, int col)
+{
+    if (col >= PANEL_WIDTH) {
+        return 0;
+    }
+    u8 b = col8[row * (PANEL_WIDTH / 16) + col / 16];
+    return (col & 8) ? b & 0x0F : b >> 4;
+}
+
+void col8_set(int row, int col, u8 nib)
+{
+    u8 *b = &col8[row * (PANEL_WIDTH / 16) + col / 16];
+    *b = (col & 8) ? (*b & 0xF0) | nib : (*b & 0x0F) | (nib << 4);
+}
+
 // 初始化SPI和显示屏
 void initDisplay() {
-    // 配置SPI
-    SPI.begin(SPI_CLK, -1, SPI_MOSI, SPI_CS);
-    // SPI.setBitOrder(MSBFIRST);
-    // SPI.setDataMode(SPI_MODE0);
-    // SPI.setClockDivider(SPI_CLOCK_DIV4);
-    SPI.beginTransaction(SPISettings(8*1000000, MSBFIRST, SPI_MODE0)); 
-    pinMode(SPI_CS, OUTPUT);
-    digitalWrite(SPI_CS, HIGH);
+    // 配置SPI：PANEL_USE_DMA 选 spi_master 排队写还是 Arduino SPI，见 jbd013_api.h
+    spi_init();
     delay(10);
+    boot_mark("SPI");
     // 初始化面板
     panel_init();
-    
+    boot_mark("面板初始化");
+#if PANEL_BENCH
+    u32 us = panel_bench();
+    Serial.printf("面板传输(%s): 整屏 %u 字节, %u us, %u KB/s\n", spi_dma_ok() ? "DMA" : "SPI",
+                  PANEL_HEIGHT * (PANEL_WIDTH / 2 + 6), us, PANEL_HEIGHT * (PANEL_WIDTH / 2 + 6) * 1000 / us);
+#endif
 }
 
 void oled_clr_cache(){
     clr_cache();  // 清除显示缓存
+    memset(col8, 0, sizeof(col8));
+    row_sig_reset(0, PANEL_HEIGHT - 1);
     send_cmd(SPI_SYNC);
     delay(100);
 }
@@ -56,38 +136,192 @@ void oled_clr_cache(){
 //     lv_disp_flush_ready(disp_drv);
 // }
 
-static u8 g_fb[PANEL_WIDTH * PANEL_HEIGHT / 2];   // 全局帧缓冲
-void my_disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+SemaphoreHandle_t panel_lock = NULL;              // 面板 SPI 由刷屏和图片解码任务共用
+
+// 一次刷新（可能分成多次 flush）的统计，最后一次 flush 时打印
+static u32 flush_count = 0;
+static u32 flush_us = 0;
+static u32 pack_us = 0;                           // 其中像素打包的耗时
+static u32 flush_bytes = 0;                       // SPI 上发出的字节数，含命令、地址和 SYNC
+static u32 sync_wait_us = 0;                      // 等上一次 SYNC 做完的时间
+static u32 refr_start_us = 0;                     // 第一块 flush 开始的时间
+static u32 rows_skipped = 0;                      // 和面板上一样没有发的行数
+disp_perf_t disp_perf;                            // 所有刷新的累计，见 my_bench.h
+#if PANEL_USE_DMA
+static u32 prev_start_us = 0;                     // 上一次刷新第一块 flush 开始的时间
+static u32 prev_refr_us = 0;                      // 上一次刷新从开始到 SYNC 发出去（DMA 全部发完）
+#endif
+static u8 row_buf[2][PANEL_WIDTH / 2];           // 打包好的行，两个轮流用：一个是还没发的上一行，一个打包当前行
+
+// 写 row 里从物理列 px1 开始的 n 个像素（px1 和 n 都是 8 的倍数）：PANEL_USE_DMA 时拷进 DMA 队列就返回，否则发完才返回
+static void flush_row(int y, int px1, int n, const u8 *row)
 {
-    for (int y = area->y1; y <= area->y2; y++) {
-        for (int x = area->x1; x <= area->x2; x++) {        
-            u32 byte_idx = (y * PANEL_WIDTH + x) >> 1;     // 8 像素/字节
-            if (x % 2) {                                   // 低 4 位
-                g_fb[byte_idx] = (color_p->full ?(0x0F&g_fb[byte_idx]) : (0xF0|g_fb[byte_idx]));
-            } else {                                       // 高 4 位
-                g_fb[byte_idx] = (color_p->full ?(0xF0&g_fb[byte_idx]) : (0x0F|g_fb[byte_idx]));
-            }
-            color_p++;
+    for (int c = 0; c < n; c += 8) {
+        col8_set(y, px1 + c, pixel_nib(row[c / 2], 0));
+    }
+    u32 len = n / 2;
+    u8 end = pixel_pair(col8_get(y, px1 + n), 0);   // 末尾会多改写下一块的第一个像素，把它原来的值带上
+#if PANEL_USE_DMA
+    spi_dma_wr_cache(px1, y, (u8 *)row, len, end);
+#else
+    spi_wr_cache_end(px1, y, (u8 *)row, len, end);
+#endif
+    flush_bytes += len + 6;
+}
+
+#if PANEL_USE_DMA
+//-----------------flush 和 DMA 重叠-----------------//
+// 一块 flush 的行全部排进 DMA 队列就返回，不调用 lv_disp_flush_ready；这一块最后一行发完时 SPI 中断里
+// flush_sent 给信号量，LVGL 要再 flush 之前在 my_flush_wait 里等到它，再告诉 LVGL 刷完了。
+// 这样 LVGL 画下一块（双缓冲的另一块）的时候，这一块还在线上发；队列能放下整块，flush 中途不会等空位。
+static SemaphoreHandle_t flush_done = NULL;
+
+static void IRAM_ATTR flush_sent(void *arg)
+{
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(flush_done, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
         }
-        spi_wr_cache(0, y, g_fb+y*PANEL_WIDTH/2, PANEL_WIDTH/2);
+    } else {
+        xSemaphoreGive(flush_done);                 // 行太长同步写了，spi_dma_wr_cache 在调用者里回调
     }
+}
 
-    /* ③ 整屏刷新 */
-    /* ④ 告诉 LVGL 刷完了 */
-    send_cmd(SPI_SYNC);
-    delay_ms(1);                   // 芯片要求的 1 ms
+static void my_flush_wait(lv_disp_drv_t *disp_drv)
+{
+    xSemaphoreTake(flush_done, portMAX_DELAY);
     lv_disp_flush_ready(disp_drv);
 }
+#endif
+
+// 逻辑 y 是物理列（px = 479 - y），把脏区域扩到物理 8 列对齐，见上面的块首列。
+// LVGL 分块时也用它算每块的行数，所以每一块 flush 都是对齐的。
+static void my_rounder(lv_disp_drv_t *disp_drv, lv_area_t *area)
+{
+    int px1 = (PANEL_WIDTH - 1 - area->y2) & ~7;
+    int px2 = (PANEL_WIDTH - 1 - area->y1) | 7;
+    area->y1 = PANEL_WIDTH - 1 - px2;
+    area->y2 = PANEL_WIDTH - 1 - px1;
+}
+
+void my_disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    u32 t0 = micros();
+    if (flush_count == 0) {
+        refr_start_us = t0;
+    }
+    xSemaphoreTake(panel_lock, portMAX_DELAY);
+    sync_wait_us += panel_sync_wait();              // 上一次刷新的 SYNC 一般早就做完了，不用等
+#if PANEL_USE_DMA
+    if (flush_count == 0 && prev_start_us != 0) {
+        prev_refr_us = panel_sync_time() - prev_start_us;   // 上面已经等到上一次的 SYNC 发出去了
+    }
+#endif
+    // area 是逻辑坐标（LV_DISP_ROT_270，不用 LVGL 软件旋转），逻辑 (x, y) 对应物理 (479 - y, x)：
+    // 面板的第 x 行是缓冲里的第 x 列，从逻辑 y2 往 y1 倒着读
+    int w = area->x2 - area->x1 + 1;
+    int px1 = PANEL_WIDTH - 1 - area->y2;           // 物理列范围，my_rounder 已经按 8 列对齐
+    int px2 = PANEL_WIDTH - 1 - area->y1;
+    int n = px2 - px1 + 1;
+    const lv_color_t *col = color_p + (area->y2 - area->y1) * w;   // 缓冲最后一行，物理列 px1
+    int pend_y = -1;                                // 打包好还没发的一行，在 row_buf[cur ^ 1]
+    int cur = 0;
+    for (int y = area->x1; y <= area->x2; y++, col++) {
+        u32 t1 = micros();
+        u32 h = pixel_pack_row(row_buf[cur], px1, col, -w, n);   // 旋转和打包一起做
+        pack_us += micros() - t1;
+        row_sig *sig = &row_sigs[y];
+        if (sig->x1 == px1 && sig->x2 == px2 && sig->hash == h) {
+            rows_skipped++;                         // 面板上已经是这些像素
+            continue;
+        }
+        *sig = {(u16)px1, (u16)px2, h};
+        if (pend_y >= 0) {
+            flush_row(pend_y, px1, n, row_buf[cur ^ 1]);
+        }
+        pend_y = y;
+        cur ^= 1;
+    }
+    // 最后一行留到这里发，好把 flush_sent 挂在它上面
+    bool ready_later = false;
+    if (pend_y >= 0) {
+#if PANEL_USE_DMA
+        if (spi_dma_ok()) {
+            spi_dma_on_done(flush_sent, NULL);
+            ready_later = true;
+        }
+#endif
+        flush_row(pend_y, px1, n, row_buf[cur ^ 1]);
+    }
+
+    /* ③ 整屏刷新，只在这次刷新的最后一块之后发一次，不在这里等它做完 */
+    if (lv_disp_flush_is_last(disp_drv) && flush_bytes > 0) {   // 每一行都没变就连 SYNC 也不用发
+#if PANEL_USE_DMA
+        panel_sync_async();                         // 排在这次刷新的最后一行后面
+#else
+        panel_sync();
+#endif
+        flush_bytes += 1;
+        if (!boot_first_frame) {
+            boot_first_frame = true;
+            boot_mark("第一帧 SYNC");
+        }
+    }
+    xSemaphoreGive(panel_lock);
+    flush_count++;
+    flush_us += micros() - t0;
+    if (lv_disp_flush_is_last(disp_drv)) {
+        disp_perf.refreshes++;
+        disp_perf.flush_us += flush_us;
+        disp_perf.pack_us += pack_us;
+        disp_perf.sync_wait_us += sync_wait_us;
+        disp_perf.bytes += flush_bytes;
+#if PANEL_USE_DMA
+        u32 stall_us = spi_dma_stall_us();
+        // 这次的行还在 DMA 队列里，传完的时间要到下一次刷新才知道，这里打印的是上一次的
+        DISP_LOG("刷新: %u 次 flush, %u 字节 (没变跳过 %u 行), flush %u us (打包 %u us, 等 DMA 空位 %u us, 等 SYNC %u us), "
+                 "正文绘制 %u us, 到最后一块 %u us; 上一次从开始到 SYNC 发出 %u us\n",
+                 flush_count, flush_bytes, rows_skipped, flush_us, pack_us, stall_us, sync_wait_us,
+                 content_draw_us, micros() - refr_start_us, prev_refr_us);
+        prev_start_us = refr_start_us;
+#else
+        DISP_LOG("刷新: %u 次 flush, %u 字节 (没变跳过 %u 行), %u us / 共 %u us (打包 %u us, 等 SYNC %u us), 正文绘制 %u us\n",
+                 flush_count, flush_bytes, rows_skipped, flush_us, micros() - refr_start_us, pack_us, sync_wait_us, content_draw_us);
+#endif
+        flush_count = 0;
+        flush_us = 0;
+        pack_us = 0;
+        flush_bytes = 0;
+        rows_skipped = 0;
+        sync_wait_us = 0;
+        content_draw_us = 0;
+    }
+    /* ④ 告诉 LVGL 刷完了：同步发完的现在就说；排进 DMA 队列的等最后一行发完，见 my_flush_wait */
+    if (!ready_later) {
+        lv_disp_flush_ready(disp_drv);
+    }
+}
 
 
-static lv_color_t buf_1[PANEL_WIDTH * 20];
-static lv_color_t buf_2[PANEL_WIDTH * 20];
+// 分块的行数要按 my_rounder 凑成 8 的倍数：20 行整屏宽时只用得上 16 行，整屏要 30 块；24 行是 20 块，每行的命令和地址少发一些
+#define DRAW_BUF_ROWS 24
+static lv_color_t buf_1[PANEL_WIDTH * DRAW_BUF_ROWS];
+static lv_color_t buf_2[PANEL_WIDTH * DRAW_BUF_ROWS];
 // LV_FONT_DECLARE(font_alipuhui20)
 void bsp_lvgl_init(void){
     
+    panel_lock = xSemaphoreCreateMutex();
+#if PANEL_USE_DMA
+    flush_done = xSemaphoreCreateBinary();
+#endif
     initDisplay();
+    row_sig_reset(0, PANEL_HEIGHT - 1);           // 面板刚清成全黑，第一帧每一行都要写
+    pixel_pack_init(PANEL_GAMMA, PANEL_GRAY);
     lv_init();
-    lv_disp_draw_buf_init(&draw_buf, buf_1, buf_2,PANEL_WIDTH * 20);
+    boot_mark("lv_init");
+    lv_disp_draw_buf_init(&draw_buf, buf_1, buf_2,PANEL_WIDTH * DRAW_BUF_ROWS);
     /* Create a timer and set its callback */
     /*Initialize the display*/
     static lv_disp_drv_t disp_drv;
@@ -95,10 +329,93 @@ void bsp_lvgl_init(void){
     disp_drv.hor_res = PANEL_WIDTH;
     disp_drv.ver_res = PANEL_HEIGHT;
     disp_drv.flush_cb = my_disp_flush;
+    disp_drv.rounder_cb = my_rounder;
+#if PANEL_USE_DMA
+    disp_drv.wait_cb = my_flush_wait;
+#endif
     disp_drv.draw_buf = &draw_buf;
     disp_drv.full_refresh = 0;
-    disp_drv.sw_rotate = 1;           // 启用软件旋转
+    disp_drv.sw_rotate = 0;           // 旋转在 my_disp_flush 打包时做，不让 LVGL 先转一遍到另一块缓冲
     disp_drv.rotated = LV_DISP_ROT_270; // 
     lv_disp_drv_register(&disp_drv);
 
-}
\ No newline at end of file
+}
+
+//-----------------空闲等待-----------------//
+// loop() 处理完一轮就睡在任务通知上：接收任务收到帧会叫醒它，否则睡到下一个 LVGL 定时器到期。
+// 没有脏区域时暂停 LVGL 的刷新定时器，不然每 LV_DISP_DEF_REFR_PERIOD 都要醒一次；醒来先恢复它，
+// 这时它早就过期，lv_timer_handler() 会马上刷新，来帧到上屏不比原来 delay(5) + 刷新周期慢。
+#define RENDER_IDLE_MAX_MS  1000      // 最多睡这么久，字形重发（GLYPH_RETRY_MS）和统计打印靠它
+#define RENDER_STATS_MS     10000     // 唤醒次数和 CPU 占用的打印间隔
+
+static u32 render_wakes = 0;
+static u32 render_busy_us = 0;                    // 醒着的时间
+static u32 render_wake_us = 0;                    // 这一轮醒来的时间
+static u32 render_stats_us = 0;                   // 这一段统计开始的时间
+
+// 开自动浅睡眠：主频不降，醒着的时候和原来一样快；没有任务要跑、SPI 也没有在传的时候芯片睡下去
+void render_sleep_init()
+{
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm = {};
+#else
+    esp_pm_config_esp32c3_t pm = {};
+#endif
+    pm.max_freq_mhz = getCpuFrequencyMhz();
+    pm.min_freq_mhz = pm.max_freq_mhz;
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    pm.light_sleep_enable = true;
+#endif
+    esp_err_t err = esp_pm_configure(&pm);
+    Serial.printf("自动浅睡眠: %s (%s)\n", pm.light_sleep_enable ? "开" : "核心没开 tickless idle，只省掉空转的唤醒",
+                  esp_err_to_name(err));
+#else
+    Serial.println("自动浅睡眠: 核心没开 CONFIG_PM_ENABLE，只省掉空转的唤醒");
+#endif
+    render_wake_us = render_stats_us = micros();
+}
+
+// 没暂停的 LVGL 定时器里最早到期的还有多久
+static u32 render_next_timer_ms()
+{
+    u32 next = RENDER_IDLE_MAX_MS;
+    for (lv_timer_t *t = lv_timer_get_next(NULL); t != NULL; t = lv_timer_get_next(t)) {
+        if (t->paused) {
+            continue;
+        }
+        u32 elapsed = lv_tick_elaps(t->last_run);
+        u32 left = elapsed >= t->period ? 0 : t->period - elapsed;
+        if (left < next) {
+            next = left;
+        }
+    }
+    return next;
+}
+
+// loop() 最后调用，next_ms 是 lv_timer_handler() 的返回值
+void render_wait(u32 next_ms)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp->inv_p == 0) {
+        lv_timer_pause(disp->refr_timer);
+        next_ms = render_next_timer_ms();
+    }
+    if (next_ms > RENDER_IDLE_MAX_MS) {
+        next_ms = RENDER_IDLE_MAX_MS;
+    }
+    render_busy_us += micros() - render_wake_us;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(next_ms));
+    render_wake_us = micros();
+    render_wakes++;
+    lv_timer_resume(disp->refr_timer);
+
+    u32 span = render_wake_us - render_stats_us;
+    if (span >= RENDER_STATS_MS * 1000) {
+        u32 permille = render_busy_us / (span / 1000);
+        Serial.printf("空闲: %u 次唤醒/s, loop 忙 %u.%u%%\n", render_wakes * 1000 / (span / 1000), permille / 10, permille % 10);
+        render_wakes = 0;
+        render_busy_us = 0;
+        render_stats_us = render_wake_us;
+    }
+}
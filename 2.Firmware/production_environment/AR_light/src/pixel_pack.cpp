@@ -0,0 +1,85 @@
+#include "pixel_pack.h"
+
+#include <math.h>
+
+// RGB565 各分量 -> 8 位亮度的一部分（0.299R + 0.587G + 0.114B），三项加起来最大 253
+static uint8_t luma_r[32], luma_g[64], luma_b[32];
+static uint8_t lv_nib[256];                // LVGL 的 8 位亮度 -> 4bit 灰度（反相、gamma）
+uint8_t gray_lut[256];
+static lv_color_t last_c0, last_c1;        // pixel_pack_row 上一对像素和它们打包的结果
+static uint8_t last_byte;
+const uint8_t bayer4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+static inline uint8_t nib_of(lv_color_t c)
+{
+#if LV_COLOR_DEPTH == 16
+    return lv_nib[luma_r[LV_COLOR_GET_R(c)] + luma_g[LV_COLOR_GET_G(c)] + luma_b[LV_COLOR_GET_B(c)]];
+#else
+    return lv_nib[lv_color_brightness(c)];
+#endif
+}
+
+void pixel_pack_init(float gamma, bool gray)
+{
+    for (int i = 0; i < 32; i++) {
+        luma_r[i] = (i * 255 / 31) * 77 >> 8;
+        luma_b[i] = (i * 255 / 31) * 29 >> 8;
+    }
+    for (int i = 0; i < 64; i++) {
+        luma_g[i] = (i * 255 / 63) * 150 >> 8;
+    }
+    for (int i = 0; i < 256; i++) {
+        float v = powf(i / 255.0f, gamma);
+        gray_lut[i] = (uint8_t)(v * 240.0f + 0.5f);
+        int n = (int)(powf((255 - i) / 255.0f, gamma) * 15.0f + 0.5f);
+        lv_nib[i] = gray ? n : (255 - i >= 128 ? 0x0F : 0x00);
+    }
+    last_c0 = lv_color_black();
+    last_c1 = lv_color_black();
+    last_byte = pixel_pair(nib_of(last_c0), nib_of(last_c1));
+}
+
+#define PACK_HASH_INIT 2166136261u
+#define PACK_HASH_MUL  16777619u
+
+// 界面大部分是成片的底色，相邻两个像素和上一对一样就直接用上一次的结果，
+// 这时每两个像素只有两次比较，和原来的二值查表差不多；颜色变了（文字边缘）才查表算灰度。
+// 散列在写每个字节时顺带算，一个字节一次异或一次乘法，不用再把这一段读一遍。
+uint32_t pixel_pack_row(uint8_t *dst, int x, const lv_color_t *src, int step, int n)
+{
+    uint32_t h = PACK_HASH_INIT;
+    if (n <= 0) {
+        return h;
+    }
+    if (x & 1) {                                     // 开头落在奇数列那半个字节
+        uint8_t nib = nib_of(src[0]);
+        pixel_set_nib(dst, 1, nib);
+        h = (h ^ nib) * PACK_HASH_MUL;
+        dst++;
+        src += step;
+        n--;
+    }
+    while (n >= 2) {
+        lv_color_t c0 = src[0], c1 = src[step];
+        if (c0.full != last_c0.full || c1.full != last_c1.full) {
+            last_c0 = c0;
+            last_c1 = c1;
+            last_byte = pixel_pair(nib_of(c0), nib_of(c1));
+        }
+        *dst++ = last_byte;
+        h = (h ^ last_byte) * PACK_HASH_MUL;
+        src += 2 * step;
+        n -= 2;
+    }
+    if (n) {                                         // 结尾落在偶数列那半个字节
+        uint8_t nib = nib_of(src[0]);
+        pixel_set_nib(dst, 0, nib);
+        h = (h ^ nib) * PACK_HASH_MUL;
+    }
+    return h;
+}
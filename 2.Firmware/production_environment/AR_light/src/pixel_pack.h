@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include "lvgl.h"
+
+//-----------------LVGL 像素 -> 面板 4bpp-----------------//
+// 面板缓存一个字节两个像素，顺序见下面的 PIXEL_EVEN_HIGH。LVGL 界面是白底黑字，黑色点亮，所以亮度反过来用。
+// 颜色先算成 8 位亮度（三张小表相加），再查一张 256 项的表得到 4bit 灰度，表里做了反相和 gamma。
+
+// 建表，bsp_lvgl_init() 里在第一次刷屏前调用。
+// gamma：面板灰度和亮度近似线性，按人眼把 8 位亮度换成 (L/255)^gamma；
+// gray 为 false 时 LVGL 内容只有亮灭（抗锯齿边缘按一半亮度二值化）。
+void pixel_pack_init(float gamma, bool gray);
+
+// 一个字节里两个像素的位置。原来刷屏的写法（面板上一直这样显示）是奇数列在高 4 位；
+// 数据手册写的是 pBuf[N] = GrayN << 4 | GrayN+1，偶数列在高 4 位，还没在面板上对过，对过再改成 1。
+// 刷屏、图片和写缓存末尾的像素都按这里的顺序。
+#define PIXEL_EVEN_HIGH  0
+#define PIXEL_EVEN_SHIFT (PIXEL_EVEN_HIGH ? 4 : 0)
+#define PIXEL_ODD_SHIFT  (PIXEL_EVEN_HIGH ? 0 : 4)
+
+// 偶数列和奇数列两个像素拼成一个字节；写缓存末尾的字节是 pixel_pair(末尾像素, 0)
+static inline uint8_t pixel_pair(uint8_t even, uint8_t odd)
+{
+    return (uint8_t)(even << PIXEL_EVEN_SHIFT | odd << PIXEL_ODD_SHIFT);
+}
+
+// 字节 b 里第 x 列（只看奇偶）的像素
+static inline uint8_t pixel_nib(uint8_t b, int x)
+{
+    return (b >> ((x & 1) ? PIXEL_ODD_SHIFT : PIXEL_EVEN_SHIFT)) & 0x0F;
+}
+
+// 只改字节 b 里第 x 列（只看奇偶）的像素
+static inline void pixel_set_nib(uint8_t *b, int x, uint8_t nib)
+{
+    int s = (x & 1) ? PIXEL_ODD_SHIFT : PIXEL_EVEN_SHIFT;
+    *b = (uint8_t)((*b & ~(0x0F << s)) | nib << s);
+}
+
+// dst 指向第 x 个像素所在的字节，x 是奇数时第一个像素只改奇数列那半个字节，末尾落在半个字节上时只改偶数列那半个。
+// 第 i 个像素取 src[i * step]：刷屏时 LVGL 的缓冲是逻辑方向，面板的一行是缓冲里的一列，
+// 旋转就在这里顺带做掉（step = -缓冲宽度），每个像素从 LVGL 缓冲到要发的行缓冲只读写一次。
+// 返回这 n 个像素打包结果的 32 位散列（FNV-1a），刷屏用它判断这一段和上次写到面板的是否一样。
+uint32_t pixel_pack_row(uint8_t *dst, int x, const lv_color_t *src, int step, int n);
+
+// 图片用：8 位亮度（不反相）-> 4bit 灰度，gamma 之后用 4x4 Bayer 有序抖动把 16 级之间的差摊到相邻像素上。
+// x、y 是像素坐标，只用来取抖动矩阵的位置。
+extern uint8_t gray_lut[256];              // 8 位亮度 -> 0~240，高 4 位是灰度，低 4 位留给抖动
+extern const uint8_t bayer4[4][4];
+static inline uint8_t pixel_dither(uint8_t luma, int x, int y)
+{
+    return (gray_lut[luma] + bayer4[y & 3][x & 3]) >> 4;
+}
+
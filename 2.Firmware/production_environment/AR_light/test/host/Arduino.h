@@ -0,0 +1,57 @@
+/*
+ * @Description: 主机单元测试用的 Arduino.h 桩，只提供被测代码用到的那几个接口
+ *
+ *   Serial       printf/print/println，默认不输出，host_serial_verbose = true 时打到 stdout
+ *   millis/micros  从进程启动开始的真实时间
+ *   FreeRTOS     见 freertos_sim.h
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <chrono>
+#include "freertos_sim.h"
+
+typedef int esp_err_t;
+#define ESP_OK            0
+#define ESP_ERR_TIMEOUT   0x107
+
+inline bool host_serial_verbose = false;
+
+inline uint64_t host_now_us()
+{
+    static const auto t0 = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+inline unsigned long millis() { return (unsigned long)(host_now_us() / 1000); }
+inline unsigned long micros() { return (unsigned long)host_now_us(); }
+inline void delay(uint32_t ms) { vTaskDelay(ms); }
+
+class HostSerial
+{
+ public:
+  void begin(unsigned long) {}
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    if (!host_serial_verbose) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+  }
+  void print(const char *s) { if (host_serial_verbose) fputs(s, stdout); }
+  void println(const char *s) { if (host_serial_verbose) puts(s); }
+};
+inline HostSerial Serial;
+
+#define ESP_LOGI(tag, ...) do { } while (0)
+#define ESP_LOGE(tag, ...) do { } while (0)
+
+#endif
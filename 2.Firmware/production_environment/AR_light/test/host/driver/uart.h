@@ -0,0 +1,89 @@
+/*
+ * @Description: 主机测试用的 ESP-IDF driver/uart.h 桩，把 my_uart.cpp 用到的调用接到 sim_uart.h 的模拟串口
+ *
+ * 两端的 my_uart.cpp 都用 LINK_UART，靠包含前定义的 SIM_UART_SIDE（SIM_S3 / SIM_C3）区分是哪一侧，
+ * 所以下面都是 static inline，每个翻译单元各用各的。
+ */
+#ifndef HOST_DRIVER_UART_H
+#define HOST_DRIVER_UART_H
+
+#include "sim_uart.h"
+
+#ifndef SIM_UART_SIDE
+#error "包含 driver/uart.h 之前要定义 SIM_UART_SIDE（SIM_S3 或 SIM_C3）"
+#endif
+
+typedef int uart_port_t;
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE, UART_PARITY_EVEN = 2, UART_PARITY_ODD } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_APB = 1 } uart_sclk_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+static inline esp_err_t uart_driver_install(uart_port_t port, int rx_buf, int tx_buf, int queue_size, QueueHandle_t *queue, int flags)
+{
+    QueueHandle_t q = sim_uart_install(SIM_UART_SIDE, queue_size);
+    if (queue) {
+        *queue = q;
+    }
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config)
+{
+    sim_uart_set_baud(SIM_UART_SIDE, config->baud_rate);
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) { return ESP_OK; }
+static inline esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t symbols) { return ESP_OK; }
+static inline esp_err_t uart_set_wakeup_threshold(uart_port_t port, int edges) { return ESP_OK; }
+
+static inline esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud)
+{
+    sim_uart_set_baud(SIM_UART_SIDE, baud);
+    return ESP_OK;
+}
+
+static inline int uart_write_bytes(uart_port_t port, const void *src, size_t size)
+{
+    return sim_uart_write(SIM_UART_SIDE, src, size);
+}
+
+static inline int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks)
+{
+    return sim_uart_read(SIM_UART_SIDE, buf, length);
+}
+
+static inline esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size)
+{
+    *size = sim_uart_buffered(SIM_UART_SIDE);
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_flush_input(uart_port_t port)
+{
+    sim_uart_flush(SIM_UART_SIDE);
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks)
+{
+    return sim_uart_wait_tx_done(SIM_UART_SIDE, ticks);
+}
+
+#endif
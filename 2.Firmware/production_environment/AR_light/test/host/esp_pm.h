@@ -0,0 +1,19 @@
+// 主机测试用的 esp_pm.h 桩：主机上不睡眠，锁建不出来，调用方按没有电源管理处理
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+#include "Arduino.h"
+
+#define ESP_ERR_NOT_SUPPORTED 0x106
+
+typedef enum { ESP_PM_CPU_FREQ_MAX, ESP_PM_APB_FREQ_MAX, ESP_PM_NO_LIGHT_SLEEP } esp_pm_lock_type_t;
+typedef struct esp_pm_lock *esp_pm_lock_handle_t;
+
+static inline esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char *name, esp_pm_lock_handle_t *out)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+static inline esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t lock) { return ESP_OK; }
+static inline esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t lock) { return ESP_OK; }
+
+#endif
@@ -0,0 +1,9 @@
+// 主机测试用的 esp_sleep.h 桩：主机上不睡眠
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include "Arduino.h"
+
+static inline esp_err_t esp_sleep_enable_uart_wakeup(int uart_num) { return ESP_OK; }
+
+#endif
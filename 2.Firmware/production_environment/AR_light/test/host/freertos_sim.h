@@ -0,0 +1,176 @@
+/*
+ * @Description: 主机测试用的 FreeRTOS 桩，只有被测代码用到的那几个接口，只有头文件
+ *
+ *   任务       std::thread，xTaskCreate 起的线程 detach，跟进程一起结束
+ *   通知       每个任务一个计数加条件变量，ulTaskNotifyTake / xTaskNotifyGive
+ *   互斥量     std::timed_mutex，和 FreeRTOS 一样不可重入
+ *   队列       创建时一次申请好固定大小的环形区，收发不再申请内存
+ * 1 tick = 1 ms。句柄指向的对象都不释放：进程退出时别的线程可能还睡在上面。
+ */
+#ifndef HOST_FREERTOS_SIM_H
+#define HOST_FREERTOS_SIM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE            1
+#define pdFALSE           0
+#define pdPASS            1
+#define portMAX_DELAY     0xffffffffu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+template <class Pred>
+inline bool host_wait(std::unique_lock<std::mutex> &lk, std::condition_variable &cv, TickType_t ticks, Pred pred)
+{
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lk, pred);
+        return true;
+    }
+    return cv.wait_for(lk, std::chrono::milliseconds(ticks), pred);
+}
+
+//------------------------------任务------------------------------//
+struct host_task
+{
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t notify = 0;
+};
+typedef host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+inline thread_local host_task *host_current_task = nullptr;
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    if (host_current_task == nullptr) {
+        host_current_task = new host_task;       // 测试主线程这类不是 xTaskCreate 起的线程
+    }
+    return host_current_task;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *out)
+{
+    host_task *t = new host_task;
+    if (out) {
+        *out = t;
+    }
+    std::thread([fn, arg, t] {
+        host_current_task = t;
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    host_task *t = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lk(t->m);
+    host_wait(lk, t->cv, ticks, [t] { return t->notify > 0; });
+    uint32_t n = t->notify;
+    if (n) {
+        t->notify = clear ? 0 : n - 1;
+    }
+    return n;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+    std::lock_guard<std::mutex> lk(t->m);
+    t->notify++;
+    t->cv.notify_one();
+    return pdPASS;
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+//------------------------------互斥量------------------------------//
+struct host_sem
+{
+    std::timed_mutex m;
+};
+typedef host_sem *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new host_sem; }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        s->m.lock();
+        return pdTRUE;
+    }
+    return s->m.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    s->m.unlock();
+    return pdTRUE;
+}
+
+//------------------------------队列------------------------------//
+struct host_queue
+{
+    std::mutex m;
+    std::condition_variable cv;
+    uint8_t *buf;
+    size_t item, cap;
+    size_t head = 0, count = 0;
+};
+typedef host_queue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item)
+{
+    host_queue *q = new host_queue;
+    q->buf = new uint8_t[len * item];
+    q->item = item;
+    q->cap = len;
+    return q;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lk(q->m);
+    if (!host_wait(lk, q->cv, ticks, [q] { return q->count < q->cap; })) {
+        return pdFALSE;
+    }
+    memcpy(q->buf + (q->head + q->count) % q->cap * q->item, item, q->item);
+    q->count++;
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *out, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lk(q->m);
+    if (!host_wait(lk, q->cv, ticks, [q] { return q->count > 0; })) {
+        return pdFALSE;
+    }
+    memcpy(out, q->buf + q->head * q->item, q->item);
+    q->head = (q->head + 1) % q->cap;
+    q->count--;
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lk(q->m);
+    q->head = 0;
+    q->count = 0;
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * @Description: 主机测试用的 lvgl.h 桩，不画图，只记下控件的内容给测试断言
+ *
+ *   label       文本存在控件里，每次改动调用 host_label_hook（在 host_lv_lock 里），测试用它记录显示过的内容
+ *   bar         只记数值
+ *   刷新        lv_obj_invalidate 只把 inv_p 加一，host_lv_render() 当作刷完一屏：睡 host_render_us 再清零
+ *   颜色        和板子上的 lv_conf 一样是 16 位 RGB565、不交换字节，pixel_pack 的测试用
+ * gui_guider.h 在 extern "C" 里包含本文件，下面的 C++ 部分包在 extern "C++" 里；
+ * 标准库头文件不能放在 extern "C" 里，所以要在 gui_guider.h 之前先包含一次本文件（sim_c3.inc 就是这样）。
+ */
+#ifndef HOST_LVGL_H
+#define HOST_LVGL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef __cplusplus
+#include <chrono>
+#include <mutex>
+#include <thread>
+#endif
+
+#define HOST_LABEL_MAX     1100          // 一帧最多 1024 字节，整帧当一个 label 的文本还放得下
+#define LV_LABEL_POS_LAST  0xFFFF
+#define LV_FONT_DECLARE(name) extern const lv_font_t name;
+
+typedef struct _lv_obj_t {
+    char text[HOST_LABEL_MAX];
+    int32_t value;
+} lv_obj_t;
+
+typedef struct {
+    int32_t line_height;
+} lv_font_t;
+
+typedef struct {
+    uint16_t inv_p;
+} lv_disp_t;
+
+#define LV_COLOR_DEPTH     16
+
+typedef union {
+    struct {
+        uint16_t blue : 5;
+        uint16_t green : 6;
+        uint16_t red : 5;
+    } ch;
+    uint16_t full;
+} lv_color_t;
+
+#define LV_COLOR_GET_R(c) ((c).ch.red)
+#define LV_COLOR_GET_G(c) ((c).ch.green)
+#define LV_COLOR_GET_B(c) ((c).ch.blue)
+
+static inline lv_color_t lv_color_make(uint8_t r, uint8_t g, uint8_t b)
+{
+    lv_color_t c;
+    c.full = (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+    return c;
+}
+
+static inline lv_color_t lv_color_black(void) { return lv_color_make(0, 0, 0); }
+static inline lv_color_t lv_color_white(void) { return lv_color_make(0xFF, 0xFF, 0xFF); }
+
+typedef struct { int dummy; } lv_style_t;
+typedef enum { LV_ANIM_OFF, LV_ANIM_ON } lv_anim_enable_t;
+typedef int lv_scr_load_anim_t;
+typedef void *lv_anim_path_cb_t;
+typedef void *lv_anim_exec_xcb_t;
+typedef void *lv_anim_start_cb_t;
+typedef void *lv_anim_ready_cb_t;
+typedef void *lv_anim_deleted_cb_t;
+
+#ifdef __cplusplus
+extern "C++" {
+inline void (*host_label_hook)(lv_obj_t *obj, const char *text) = nullptr;
+inline uint32_t host_render_us = 0;
+
+inline std::mutex &host_lv_lock()
+{
+    static std::mutex *m = new std::mutex;
+    return *m;
+}
+
+inline lv_disp_t *lv_disp_get_default()
+{
+    static lv_disp_t disp = {0};
+    return &disp;
+}
+
+inline void lv_obj_invalidate(lv_obj_t *obj) { lv_disp_get_default()->inv_p++; }
+
+inline void host_label_changed(lv_obj_t *obj)
+{
+    if (host_label_hook) {
+        host_label_hook(obj, obj->text);
+    }
+    lv_obj_invalidate(obj);
+}
+
+inline void lv_label_set_text(lv_obj_t *obj, const char *text)
+{
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    snprintf(obj->text, sizeof(obj->text), "%s", text);
+    host_label_changed(obj);
+}
+
+inline void lv_label_set_text_fmt(lv_obj_t *obj, const char *fmt, ...)
+{
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(obj->text, sizeof(obj->text), fmt, ap);
+    va_end(ap);
+    host_label_changed(obj);
+}
+
+inline void lv_label_ins_text(lv_obj_t *obj, uint32_t pos, const char *text)
+{
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    size_t n = strlen(obj->text);
+    snprintf(obj->text + n, sizeof(obj->text) - n, "%s", text);   // 只支持 LV_LABEL_POS_LAST
+    host_label_changed(obj);
+}
+
+inline void lv_bar_set_value(lv_obj_t *obj, int32_t value, lv_anim_enable_t anim)
+{
+    obj->value = value;
+    lv_obj_invalidate(obj);
+}
+
+// 测试线程读 label，和 loop 线程的改动互斥
+inline void host_label_text(const lv_obj_t *obj, char *out, size_t cap)
+{
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    snprintf(out, cap, "%s", obj->text);
+}
+
+// 代替 lv_timer_handler()：有无效区域就当作刷一屏
+inline void host_lv_render()
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp->inv_p == 0) {
+        return;
+    }
+    if (host_render_us) {
+        std::this_thread::sleep_for(std::chrono::microseconds(host_render_us));
+    }
+    disp->inv_p = 0;
+}
+}
+#endif
+
+#endif
@@ -0,0 +1,18 @@
+// 测试用到的两侧接口：sim_c3.inc 和 sim_s3.inc 里定义，发送函数是 AR_glass/src/my_uart.cpp 里的
+#ifndef HOST_SIM_SIDES_H
+#define HOST_SIM_SIDES_H
+
+#include "lvgl.h"
+#include "ar_link.h"
+
+void sim_c3_start();                         // 起 C3 的 loop 线程，它会装驱动并发 HELLO
+lv_obj_t *sim_c3_label(char cmd);            // 'a'~'h' 对应的 label，'i' 是进度条
+ar_link::ParserStats sim_c3_parser_stats();
+uint32_t sim_c3_ring_drops();
+
+void sim_s3_start();                         // S3 装驱动，协商任务开始测速和切换波特率
+void send_content(char *str);
+void send_pages(char *str);
+size_t my_uart_link_stats(char *out, size_t cap);
+
+#endif
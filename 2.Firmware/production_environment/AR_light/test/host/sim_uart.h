@@ -0,0 +1,236 @@
+/*
+ * @Description: 主机测试里 S3 和 C3 之间的串口，两端的 my_uart.cpp 通过 driver/uart.h 桩接到这里
+ *
+ * 线本身是 shared/ar_link/ar_link_sim.h 的 SimLink（限速、抖动、丢字节、翻 bit、波特率不一致收乱码），
+ * 这里补上驱动的那部分：
+ *   - 每一侧一个事件队列，接收端攒够 SIM_UART_RX_THRESH 字节或者线上空闲 2 个字符就发 UART_DATA，
+ *     和 uart_set_rx_timeout(2) 加 FIFO 满阈值的行为一样；事件由一个后台线程按字节到达时间发出
+ *   - 对端还没装驱动时发出去的字节直接丢掉（上电早的一端发的 HELLO 对端收不到）
+ *   - 时间用真实时钟，所以波特率限速是真的要等的；sim_uart_throttle(false) 以后不限速，跑浸泡测试用
+ * 测试线程也可以当其中一侧：sim_uart_attach() 以后直接调用 sim_uart_write / sim_uart_read。
+ */
+#ifndef HOST_SIM_UART_H
+#define HOST_SIM_UART_H
+
+#include "Arduino.h"
+#include "ar_link.h"
+#include "ar_link_sim.h"
+
+#define SIM_S3 0
+#define SIM_C3 1
+#define SIM_UART_RX_THRESH 120     // ESP32 驱动默认的 FIFO 满阈值
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+struct sim_side
+{
+    bool installed = false;
+    QueueHandle_t events = nullptr;
+    uint64_t announced = 0;        // 已经用 UART_DATA 报告过的累计字节数
+    uint32_t baud = AR_LINK_BAUD_DEFAULT;
+};
+
+struct sim_state
+{
+    std::mutex m;
+    std::condition_variable cv;    // 有字节写进线上时叫醒事件线程和等数据的测试线程
+    ar_link::SimLink line{AR_LINK_BAUD_DEFAULT};
+    sim_side side[2];
+    bool throttle = true;
+    bool wire_started = false;
+};
+
+inline sim_state &sim()
+{
+    static sim_state *s = new sim_state;      // 不析构，进程退出时后台线程还在用
+    return *s;
+}
+
+inline ar_link::SimPipe &sim_tx(int side) { return side == SIM_S3 ? sim().line.s3_to_c3 : sim().line.c3_to_s3; }
+inline ar_link::SimPipe &sim_rx(int side) { return side == SIM_S3 ? sim().line.c3_to_s3 : sim().line.s3_to_c3; }
+
+inline std::unique_lock<std::mutex> sim_uart_lock() { return std::unique_lock<std::mutex>(sim().m); }
+
+// 模拟驱动的接收中断，调用者持有锁；返回下一次需要检查的时间
+inline uint64_t sim_uart_poll(uint64_t now)
+{
+    sim_state &s = sim();
+    uint64_t wake = now + 10000;
+    for (int i = 0; i < 2; i++) {
+        sim_side &d = s.side[i];
+        if (d.events == nullptr) {
+            continue;
+        }
+        ar_link::SimPipe &rx = sim_rx(i);
+        uint64_t arrived = rx.stats().bytes_out + rx.available(now);
+        uint64_t next = rx.next_arrival_us(now);
+        uint64_t idle = rx.cfg.baud ? 2 * 10000000ull / rx.cfg.baud : 0;   // 2 个字符的时间
+        if (arrived > d.announced && (arrived - d.announced >= SIM_UART_RX_THRESH || next == 0 || next > now + idle)) {
+            uart_event_t e = {UART_DATA, (size_t)(arrived - d.announced), false};
+            if (xQueueSend(d.events, &e, 0)) {
+                d.announced = arrived;
+            }
+        }
+        if (next && next < wake) {
+            wake = next;
+        }
+        if (arrived > d.announced && now + idle < wake) {
+            wake = now + idle + 1;
+        }
+    }
+    return wake;
+}
+
+inline void sim_uart_wire_task()
+{
+    sim_state &s = sim();
+    const auto t0 = std::chrono::steady_clock::now() - std::chrono::microseconds(host_now_us());
+    std::unique_lock<std::mutex> lk(s.m);
+    for (;;) {
+        uint64_t wake = sim_uart_poll(host_now_us());
+        s.cv.wait_until(lk, t0 + std::chrono::microseconds(wake));
+    }
+}
+
+inline void sim_uart_start_wire()
+{
+    sim_state &s = sim();
+    if (!s.wire_started) {
+        s.wire_started = true;
+        std::thread(sim_uart_wire_task).detach();
+    }
+}
+
+// 测试线程自己当这一侧，不要事件队列
+inline void sim_uart_attach(int side)
+{
+    std::lock_guard<std::mutex> lk(sim().m);
+    sim().side[side].installed = true;
+}
+
+inline QueueHandle_t sim_uart_install(int side, int queue_size)
+{
+    sim_state &s = sim();
+    std::lock_guard<std::mutex> lk(s.m);
+    sim_side &d = s.side[side];
+    if (d.events == nullptr) {
+        d.events = xQueueCreate(queue_size, sizeof(uart_event_t));
+    }
+    d.installed = true;
+    d.announced = sim_rx(side).stats().bytes_out + sim_rx(side).available(host_now_us());   // 装驱动之前到的不算
+    sim_uart_start_wire();
+    return d.events;
+}
+
+inline void sim_uart_set_baud(int side, uint32_t baud)
+{
+    sim_state &s = sim();
+    std::lock_guard<std::mutex> lk(s.m);
+    s.side[side].baud = baud;
+    sim_tx(side).cfg.baud = s.throttle ? baud : 0;
+    sim_rx(side).cfg.rx_baud = s.throttle ? baud : 0;
+}
+
+inline uint32_t sim_uart_baud(int side)
+{
+    std::lock_guard<std::mutex> lk(sim().m);
+    return sim().side[side].baud;
+}
+
+// 在两端装驱动之前调用
+inline void sim_uart_throttle(bool on)
+{
+    sim_state &s = sim();
+    std::lock_guard<std::mutex> lk(s.m);
+    s.throttle = on;
+    for (int i = 0; i < 2; i++) {
+        sim_tx(i).cfg.baud = on ? s.side[i].baud : 0;
+        sim_rx(i).cfg.rx_baud = on ? s.side[i].baud : 0;
+    }
+}
+
+inline int sim_uart_write(int side, const void *data, size_t n)
+{
+    sim_state &s = sim();
+    std::lock_guard<std::mutex> lk(s.m);
+    if (s.side[!side].installed) {
+        sim_tx(side).write((const uint8_t *)data, n, host_now_us());
+        s.cv.notify_all();
+    }
+    return (int)n;
+}
+
+inline int sim_uart_read(int side, void *buf, size_t n)
+{
+    std::lock_guard<std::mutex> lk(sim().m);
+    return (int)sim_rx(side).read((uint8_t *)buf, n, host_now_us());
+}
+
+inline size_t sim_uart_buffered(int side)
+{
+    std::lock_guard<std::mutex> lk(sim().m);
+    return sim_rx(side).available(host_now_us());
+}
+
+// 等这一侧收到数据，最多等 timeout_us；返回已经到达的字节数
+inline size_t sim_uart_wait_rx(int side, uint64_t timeout_us)
+{
+    sim_state &s = sim();
+    const auto t0 = std::chrono::steady_clock::now() - std::chrono::microseconds(host_now_us());
+    uint64_t deadline = host_now_us() + timeout_us;
+    std::unique_lock<std::mutex> lk(s.m);
+    for (;;) {
+        uint64_t now = host_now_us();
+        size_t n = sim_rx(side).available(now);
+        if (n > 0 || now >= deadline) {
+            return n;
+        }
+        uint64_t next = sim_rx(side).next_arrival_us(now);
+        s.cv.wait_until(lk, t0 + std::chrono::microseconds(next && next < deadline ? next : deadline));
+    }
+}
+
+inline void sim_uart_flush(int side)
+{
+    uint8_t buf[256];
+    while (sim_uart_read(side, buf, sizeof(buf)) > 0) {
+    }
+}
+
+inline esp_err_t sim_uart_wait_tx_done(int side, TickType_t ticks)
+{
+    uint64_t deadline = host_now_us() + (uint64_t)ticks * 1000;
+    for (;;) {
+        uint64_t drain;
+        {
+            std::lock_guard<std::mutex> lk(sim().m);
+            drain = sim_tx(side).drain_us();
+        }
+        uint64_t now = host_now_us();
+        if (drain <= now) {
+            return ESP_OK;
+        }
+        if (now >= deadline) {
+            return ESP_ERR_TIMEOUT;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds((drain < deadline ? drain : deadline) - now));
+    }
+}
+
+#endif
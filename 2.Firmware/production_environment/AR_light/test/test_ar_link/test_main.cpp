@@ -0,0 +1,229 @@
+// 串口帧协议（shared/ar_link/ar_link.h）的主机测试：编解码往返、坏长度，
+// 以及随机翻位、丢字节、插字节、截断之后解析器能在下一个同步字重新对上，好帧一个不少。
+#include <unity.h>
+#include <vector>
+#include "ar_link.h"
+#include "ar_link_sim.h"
+
+struct rx_frame
+{
+    uint8_t type;
+    uint8_t seq;
+    std::vector<uint8_t> data;
+};
+
+static std::vector<rx_frame> got;
+
+static void on_frame(const ar_link::Frame &f)
+{
+    got.push_back({f.type, f.seq, std::vector<uint8_t>(f.data, f.data + f.len)});
+}
+
+static uint32_t rng = 1;
+static uint32_t rnd()                      // xorshift32，固定种子，每次结果一样
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static std::vector<uint8_t> make_frame(uint8_t type, uint8_t seq, const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> out(AR_LINK_HEADER_MAX + data.size() + AR_LINK_CRC_LEN);
+    out.resize(ar_link::encode(out.data(), out.size(), type, seq, data.data(), data.size()));
+    return out;
+}
+
+static rx_frame random_frame(uint8_t seq, size_t max_len)
+{
+    rx_frame f;
+    f.type = 'a' + rnd() % 20;
+    f.seq = seq;
+    f.data.resize(rnd() % (max_len + 1));
+    for (uint8_t &b : f.data) {
+        b = (uint8_t)rnd();
+    }
+    // 数据里故意放一些同步字，解析器不能把它们当帧头
+    if (f.data.size() > 4 && rnd() % 4 == 0) {
+        size_t p = rnd() % (f.data.size() - 1);
+        f.data[p] = AR_LINK_SYNC0;
+        f.data[p + 1] = AR_LINK_SYNC1;
+    }
+    return f;
+}
+
+static bool same(const rx_frame &a, const rx_frame &b)
+{
+    return a.type == b.type && a.seq == b.seq && a.data == b.data;
+}
+
+// 把剩下卡在缓冲里的半帧冲掉：最长一帧那么多的 0
+template <size_t N>
+static void flush(ar_link::Parser<N> &p)
+{
+    std::vector<uint8_t> zeros(AR_LINK_HEADER_MAX + N + AR_LINK_CRC_LEN, 0);
+    p.feed(zeros.data(), zeros.size(), on_frame);
+}
+
+void setUp(void)
+{
+    got.clear();
+    rng = 12345;
+}
+
+void tearDown(void) {}
+
+//-----------------------------用例-----------------------------//
+static void test_roundtrip_lengths(void)
+{
+    const size_t lens[] = {0, 1, 127, 128, 300, 16383, 16384};
+    ar_link::Parser<20000> p;
+    std::vector<rx_frame> sent;
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        rx_frame f = random_frame((uint8_t)i, 0);
+        f.data.assign(lens[i], (uint8_t)(0x30 + i));
+        std::vector<uint8_t> bytes = make_frame(f.type, f.seq, f.data);
+        TEST_ASSERT_EQUAL(lens[i] < 128 ? 5 : lens[i] < 16384 ? 6 : 7, bytes.size() - lens[i] - AR_LINK_CRC_LEN);
+        for (uint8_t b : bytes) {
+            p.feed(&b, 1, on_frame);                // 一次一个字节
+        }
+        sent.push_back(f);
+    }
+    TEST_ASSERT_EQUAL(sent.size(), got.size());
+    for (size_t i = 0; i < sent.size(); i++) {
+        TEST_ASSERT_TRUE(same(sent[i], got[i]));
+    }
+    TEST_ASSERT_EQUAL(0, p.stats().skipped);
+    TEST_ASSERT_EQUAL(0, p.stats().crc_errors);
+}
+
+static void test_bad_length_recovers(void)
+{
+    ar_link::Parser<64> p;
+    // 长度 65 超过上限；长度字段 4 个字节都带续位，超过 varint 最长
+    std::vector<uint8_t> big = make_frame('a', 1, std::vector<uint8_t>(65, 'x'));
+    std::vector<uint8_t> varint = {AR_LINK_SYNC0, AR_LINK_SYNC1, 'a', 2, 0x80, 0x80, 0x80, 0x01};
+    std::vector<uint8_t> good = make_frame('b', 3, std::vector<uint8_t>(10, 'y'));
+    std::vector<uint8_t> stream = big;
+    stream.insert(stream.end(), varint.begin(), varint.end());
+    stream.insert(stream.end(), good.begin(), good.end());
+    p.feed(stream.data(), stream.size(), on_frame);
+    TEST_ASSERT_EQUAL(1, got.size());
+    TEST_ASSERT_EQUAL('b', got[0].type);
+    TEST_ASSERT_EQUAL(3, got[0].seq);
+    TEST_ASSERT_EQUAL(2, p.stats().len_errors);
+    TEST_ASSERT_EQUAL(1, p.stats().resyncs);
+}
+
+static void test_fuzz_corruption_recovery(void)
+{
+    const int frames = 20000;
+    ar_link::Parser<> p;
+    std::vector<rx_frame> intact;             // 没被破坏的帧，必须按顺序全部收到
+    std::vector<uint8_t> stream;
+    int corrupted = 0;
+    for (int i = 0; i < frames; i++) {
+        rx_frame f = random_frame((uint8_t)i, i % 50 == 0 ? AR_LINK_MAX_PAYLOAD : 200);
+        std::vector<uint8_t> bytes = make_frame(f.type, f.seq, f.data);
+        bool ok = false;
+        switch (rnd() % 10) {
+        case 0:                               // 翻一个 bit
+            bytes[rnd() % bytes.size()] ^= (uint8_t)(1u << (rnd() & 7));
+            break;
+        case 1:                               // 丢一个字节
+            bytes.erase(bytes.begin() + rnd() % bytes.size());
+            break;
+        case 2:                               // 帧里面插一个字节
+            bytes.insert(bytes.begin() + 1 + rnd() % (bytes.size() - 1), (uint8_t)rnd());
+            break;
+        case 3:                               // 只发了前半截
+            bytes.resize(rnd() % bytes.size());
+            break;
+        case 4: {                             // 帧前面夹一段带同步字的杂字节
+            std::vector<uint8_t> junk = {AR_LINK_SYNC0, AR_LINK_SYNC1, (uint8_t)rnd(), (uint8_t)rnd(), (uint8_t)(rnd() & 0x7f)};
+            for (int k = rnd() % 8; k > 0; k--) junk.push_back((uint8_t)rnd());
+            bytes.insert(bytes.begin(), junk.begin(), junk.end());
+            ok = true;
+            break;
+        }
+        default:
+            ok = true;
+            break;
+        }
+        if (ok) {
+            intact.push_back(f);
+        } else {
+            corrupted++;
+        }
+        stream.insert(stream.end(), bytes.begin(), bytes.end());
+    }
+    for (size_t pos = 0; pos < stream.size();) {  // 按随机大小分块喂，模拟串口一次读到多少算多少
+        size_t n = 1 + rnd() % 300;
+        if (n > stream.size() - pos) n = stream.size() - pos;
+        p.feed(stream.data() + pos, n, on_frame);
+        pos += n;
+    }
+    flush(p);
+
+    // 好帧按顺序都在；坏帧偶尔会被 CRC16 放过（概率 1/65536），收到的多余帧不能多
+    size_t k = 0;
+    for (size_t i = 0; i < got.size() && k < intact.size(); i++) {
+        if (same(got[i], intact[k])) k++;
+    }
+    TEST_ASSERT_EQUAL(intact.size(), k);
+    TEST_ASSERT_LESS_OR_EQUAL(corrupted / 1000 + 1, got.size() - intact.size());
+    TEST_ASSERT_GREATER_THAN(0, p.stats().crc_errors);
+    TEST_ASSERT_GREATER_THAN(corrupted / 2, p.stats().resyncs);
+}
+
+static void test_sim_line_loss(void)
+{
+    // 经过模拟串口线：按概率丢字节、翻 bit，收到的帧都得是发出去的，而且顺序不乱
+    ar_link::SimPipe line(2000000);
+    line.cfg.loss_ppm = 200;
+    line.cfg.flip_ppm = 200;
+    line.cfg.jitter_us = 50;
+    line.reseed();
+    ar_link::Parser<> p;
+    std::vector<rx_frame> sent;
+    uint64_t now = 0;
+    uint8_t buf[256];
+    for (int i = 0; i < 5000; i++) {
+        rx_frame f = random_frame((uint8_t)i, 300);
+        std::vector<uint8_t> bytes = make_frame(f.type, f.seq, f.data);
+        line.write(bytes.data(), bytes.size(), now);
+        sent.push_back(f);
+        now += 2000;
+        size_t n;
+        while ((n = line.read(buf, sizeof(buf), now)) > 0) {
+            p.feed(buf, n, on_frame);
+        }
+    }
+    size_t n;
+    while ((n = line.read(buf, sizeof(buf), UINT64_MAX)) > 0) {
+        p.feed(buf, n, on_frame);
+    }
+    flush(p);
+
+    size_t k = 0;
+    for (const rx_frame &f : got) {
+        while (k < sent.size() && !same(sent[k], f)) k++;
+        TEST_ASSERT_TRUE_MESSAGE(k < sent.size(), "收到了没发过或者乱序的帧");
+        k++;
+    }
+    uint32_t damaged = line.stats().lost + line.stats().flipped;
+    TEST_ASSERT_GREATER_THAN(0, damaged);
+    TEST_ASSERT_GREATER_OR_EQUAL(sent.size() - damaged, got.size());   // 每个坏字节最多毁掉一帧
+    TEST_ASSERT_GREATER_THAN(0, p.stats().resyncs);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip_lengths);
+    RUN_TEST(test_bad_length_recovers);
+    RUN_TEST(test_fuzz_corruption_recovery);
+    RUN_TEST(test_sim_line_loss);
+    return UNITY_END();
+}
@@ -0,0 +1,2 @@
+// 模拟串口的 S3 一侧，见 test/host/sim_s3.inc
+#include "sim_s3.inc"
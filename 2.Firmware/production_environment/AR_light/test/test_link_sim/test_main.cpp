@@ -0,0 +1,216 @@
+// S3 和 C3 两端真正的 my_uart.cpp 在主机上对接（sim_s3.cpp / sim_c3.cpp），中间是 sim_uart.h 的模拟串口：
+// 上电协商波特率，S3 发页面，C3 收帧、改 label、回 ACK。label 的每次改动都经过钩子检查，
+// 干净的线和带丢字节、翻 bit、抖动的线各跑一遍，同时打印每页的端到端延迟和吞吐，当作链路的基准测试。
+#include <unity.h>
+#include "sim_uart.h"
+#include "sim_sides.h"
+
+#define PAGE_FILL   300              // 每页正文长度，和一页中文的字节数差不多
+#define PAGES_MAX   4096
+#define NEGOTIATE_PAGES 100          // 协商期间最多发这么多页，之后的用例从这里往后编号
+
+static uint64_t sent_us[PAGES_MAX];
+// 下面几个由钩子在 host_lv_lock 里改
+static uint64_t shown_us[PAGES_MAX];
+static int last_page = -1;
+static int shown_pages = 0;
+static int order_errors = 0;         // 显示的页比之前显示过的还旧
+static int garbage = 0;              // 显示了不是 S3 发过的内容
+
+static void make_page(char *buf, int page)
+{
+    int n = sprintf(buf, "page %05d ", page);
+    for (int i = 0; i < PAGE_FILL; i++) {
+        buf[n + i] = 'a' + (page + i) % 26;
+    }
+    buf[n + PAGE_FILL] = 0;
+}
+
+static void on_label(lv_obj_t *obj, const char *text)
+{
+    if (obj != sim_c3_label('a')) {
+        return;
+    }
+    char expect[32 + PAGE_FILL];
+    int page = atoi(text + 5);
+    make_page(expect, page);
+    if (strncmp(text, "page ", 5) != 0 || page < 0 || page >= PAGES_MAX || strcmp(text, expect) != 0) {
+        garbage++;
+        return;
+    }
+    if (page <= last_page) {
+        order_errors++;
+    }
+    last_page = page;
+    shown_us[page] = host_now_us();
+    shown_pages++;
+}
+
+static void send_page(int page)
+{
+    char buf[32 + PAGE_FILL];
+    make_page(buf, page);
+    sent_us[page] = host_now_us();
+    send_content(buf);
+}
+
+// 等 C3 显示出这一页，返回是否等到
+static bool wait_shown(int page, uint32_t timeout_ms)
+{
+    uint32_t start = millis();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lk(host_lv_lock());
+            if (shown_us[page]) return true;
+        }
+        if (millis() - start > timeout_ms) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+static void reset_history()
+{
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    shown_pages = 0;
+    order_errors = 0;
+    garbage = 0;
+}
+
+static void set_noise(uint32_t loss_ppm, uint32_t flip_ppm, uint32_t jitter_us)
+{
+    auto lk = sim_uart_lock();
+    for (int side = 0; side < 2; side++) {
+        sim_tx(side).cfg.loss_ppm = loss_ppm;
+        sim_tx(side).cfg.flip_ppm = flip_ppm;
+        sim_tx(side).cfg.jitter_us = jitter_us;
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+//-----------------------------用例-----------------------------//
+static void test_negotiate(void)
+{
+    // C3 先上电，HELLO 没人收；S3 上电后自己开始测速协商。
+    // 协商期间照常翻页：页面要排队等协商完再发，不能在两端波特率对不上的时候发出去变成乱码
+    uint32_t start = millis();
+    int page = 0;
+    while (!(sim_uart_baud(SIM_S3) != AR_LINK_BAUD_DEFAULT && sim_uart_baud(SIM_S3) == sim_uart_baud(SIM_C3))) {
+        TEST_ASSERT_TRUE_MESSAGE(millis() - start < 10000, "10 秒内没有协商到更高的波特率");
+        if (page < NEGOTIATE_PAGES) {
+            send_page(page++);
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));                  // 协商任务收尾
+    TEST_ASSERT_EQUAL(AR_LINK_BAUD_MAX, sim_uart_baud(SIM_S3));
+    TEST_ASSERT_EQUAL(AR_LINK_BAUD_MAX, sim_uart_baud(SIM_C3));
+    TEST_ASSERT_TRUE_MESSAGE(wait_shown(page - 1, 1000), "协商期间发的最后一页没有显示");
+    {
+        std::lock_guard<std::mutex> lk(host_lv_lock());
+        TEST_ASSERT_EQUAL(0, garbage);
+        TEST_ASSERT_EQUAL(0, order_errors);
+    }
+    TEST_ASSERT_EQUAL(0, sim_c3_parser_stats().crc_errors);
+    char msg[80];
+    snprintf(msg, sizeof(msg), "协商到 %lu baud 用了 %lu ms", (unsigned long)sim_uart_baud(SIM_S3), (unsigned long)(millis() - start));
+    TEST_MESSAGE(msg);
+}
+
+static void test_clean_pages(void)
+{
+    reset_history();
+    // 一页一页翻：每页都要显示出来，记端到端延迟
+    const int first = NEGOTIATE_PAGES, paced = 200;
+    uint64_t total = 0, worst = 0;
+    for (int i = first; i < first + paced; i++) {
+        send_page(i);
+        TEST_ASSERT_TRUE_MESSAGE(wait_shown(i, 1000), "页面 1 秒内没有显示");
+        uint64_t us = shown_us[i] - sent_us[i];
+        total += us;
+        if (us > worst) worst = us;
+    }
+    // 连续快速翻页：中间的页可以被新页作废，最后一页必须显示，顺序不能乱
+    const int burst = 1000;
+    uint64_t t0 = host_now_us();
+    for (int i = first + paced; i < first + paced + burst; i++) {
+        send_page(i);
+    }
+    TEST_ASSERT_TRUE(wait_shown(first + paced + burst - 1, 2000));
+    uint64_t burst_us = shown_us[first + paced + burst - 1] - t0;
+
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    TEST_ASSERT_EQUAL(0, garbage);
+    TEST_ASSERT_EQUAL(0, order_errors);
+    TEST_ASSERT_EQUAL(0, sim_c3_parser_stats().crc_errors);
+    TEST_ASSERT_EQUAL(0, sim_c3_ring_drops());
+    char msg[200];
+    snprintf(msg, sizeof(msg), "逐页: 平均 %lu us 最大 %lu us；连发 %d 页: 最后一页 %lu us 后显示，中间显示了 %d 页，其余被新页作废",
+             (unsigned long)(total / paced), (unsigned long)worst, burst, (unsigned long)burst_us, shown_pages - paced - 1);
+    TEST_MESSAGE(msg);
+}
+
+static void test_noisy_line(void)
+{
+    reset_history();
+    // 每页等它显示或者等 30ms：页丢了、ACK 丢了，S3 的信用用完后要等 ACK 超时重新协商
+    set_noise(50, 50, 200);
+    const int first = 2000, pages = 300;
+    for (int i = first; i < first + pages; i++) {
+        send_page(i);
+        wait_shown(i, 30);
+    }
+    // 线恢复干净：ACK 丢了的话 S3 会超时重新协商，之后最后一页一定要能显示出来
+    set_noise(0, 0, 0);
+    vTaskDelay(pdMS_TO_TICKS(200));
+    const int final_page = PAGES_MAX - 1;
+    send_page(final_page);
+    TEST_ASSERT_TRUE_MESSAGE(wait_shown(final_page, 5000), "线恢复后最后一页没有显示");
+
+    ar_link::ParserStats ps = sim_c3_parser_stats();
+    ar_link::SimPipeStats down, up;
+    {
+        auto lk = sim_uart_lock();
+        down = sim_tx(SIM_S3).stats();
+        up = sim_tx(SIM_C3).stats();
+    }
+    std::lock_guard<std::mutex> lk(host_lv_lock());
+    TEST_ASSERT_EQUAL(0, garbage);
+    TEST_ASSERT_EQUAL(0, order_errors);
+    TEST_ASSERT_GREATER_THAN(0, down.lost + down.flipped);
+    TEST_ASSERT_GREATER_THAN(0, ps.crc_errors + ps.len_errors + ps.resyncs);
+    // 每页最多等 30ms，丢了的页要等 ACK 超时；这样的噪声下至少一半的页要能显示出来
+    TEST_ASSERT_GREATER_OR_EQUAL((pages + 1) / 2, shown_pages);
+    char msg[200];
+    snprintf(msg, sizeof(msg), "噪声线: 发 %d 页显示 %d 页；S3->C3 丢 %lu 翻 %lu，C3->S3 丢 %lu 翻 %lu；C3 crc%lu len%lu resync%lu",
+             pages + 1, shown_pages, (unsigned long)down.lost, (unsigned long)down.flipped, (unsigned long)up.lost,
+             (unsigned long)up.flipped, (unsigned long)ps.crc_errors, (unsigned long)ps.len_errors, (unsigned long)ps.resyncs);
+    TEST_MESSAGE(msg);
+}
+
+static void test_link_stats(void)
+{
+    // 第一次读顺便请 C3 上报，第二次读就带上 C3 的统计
+    char stats[2048];
+    my_uart_link_stats(stats, sizeof(stats));
+    vTaskDelay(pdMS_TO_TICKS(500));                  // 噪声用例之后链路可能退回了 115200
+    my_uart_link_stats(stats, sizeof(stats));
+    TEST_ASSERT_NOT_NULL(strstr(stats, "S3 crc"));
+    TEST_ASSERT_NOT_NULL(strstr(stats, "C3 crc"));
+}
+
+int main(int argc, char **argv)
+{
+    host_label_hook = on_label;
+    host_render_us = 2000;                           // 刷一屏大约 2ms
+    sim_c3_start();
+    vTaskDelay(pdMS_TO_TICKS(20));
+    sim_s3_start();
+    UNITY_BEGIN();
+    RUN_TEST(test_negotiate);
+    RUN_TEST(test_clean_pages);
+    RUN_TEST(test_noisy_line);
+    RUN_TEST(test_link_stats);
+    return UNITY_END();
+}
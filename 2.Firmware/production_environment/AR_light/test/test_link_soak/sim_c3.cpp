@@ -0,0 +1,2 @@
+// 模拟串口的 C3 一侧，见 test/host/sim_c3.inc
+#include "sim_c3.inc"
@@ -0,0 +1,228 @@
+// C3 一侧的浸泡测试：测试线程当 S3，在不限速的模拟串口上按 3 个信用连发一百万个显示帧，
+// 每帧后面跟一个 PING，让接收任务回 PONG 的同时 loop() 回 ACK，两个任务抢着发。
+// 检查：每帧都有 ACK、没有丢帧，C3 发出的序号连续，热身之后堆上没有新分配、最高水位不涨。
+#include <unity.h>
+#include <atomic>
+#include "sim_uart.h"
+#include "sim_sides.h"
+
+#ifndef SOAK_FRAMES
+#define SOAK_FRAMES  1000000
+#endif
+#define SOAK_WARMUP  10000           // 热身帧数，之后堆不能再动
+
+//-----------------------------堆计数-----------------------------//
+// glibc 下把 malloc 一族接过来，数分配次数、记当前占用和最高水位；new 也走 malloc
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define SOAK_HEAP 1
+extern "C" void *__libc_malloc(size_t n);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t n);
+extern "C" void __libc_free(void *p);
+
+static std::atomic<uint64_t> heap_allocs{0};
+static std::atomic<int64_t> heap_bytes{0};
+static std::atomic<int64_t> heap_peak{0};
+
+static void heap_add(void *p)
+{
+    if (p == nullptr) {
+        return;
+    }
+    heap_allocs++;
+    int64_t now = heap_bytes += (int64_t)malloc_usable_size(p);
+    int64_t peak = heap_peak.load();
+    while (now > peak && !heap_peak.compare_exchange_weak(peak, now)) {
+    }
+}
+
+static void heap_sub(void *p)
+{
+    if (p) {
+        heap_bytes -= (int64_t)malloc_usable_size(p);
+    }
+}
+
+extern "C" void *malloc(size_t n)
+{
+    void *p = __libc_malloc(n);
+    heap_add(p);
+    return p;
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+    void *p = __libc_calloc(n, size);
+    heap_add(p);
+    return p;
+}
+
+extern "C" void *realloc(void *old, size_t n)
+{
+    heap_sub(old);
+    void *p = __libc_realloc(old, n);
+    heap_add(p ? p : (n ? old : nullptr));      // 失败时旧块还在
+    return p;
+}
+
+extern "C" void free(void *p)
+{
+    heap_sub(p);
+    __libc_free(p);
+}
+#else
+#define SOAK_HEAP 0
+#endif
+
+//-----------------------------S3 一侧-----------------------------//
+static ar_link::Parser<> rx;
+static int credits = AR_LINK_CREDITS;
+static uint8_t inflight[AR_LINK_CREDITS];    // 在途帧的序号，按发送顺序
+static int inflight_n = 0;
+static uint32_t acks = 0, ack_order_errors = 0, dropped = 0, pongs = 0, hellos = 0;
+static uint32_t c3_frames = 0, c3_seq_errors = 0;
+static uint8_t c3_seq = 0;
+
+static void on_frame(const ar_link::Frame &f)
+{
+    if (c3_frames++ && f.seq != (uint8_t)(c3_seq + 1)) {
+        c3_seq_errors++;                     // C3 的序号跳了或者乱序
+    }
+    c3_seq = f.seq;
+    switch (f.type) {
+    case AR_LINK_HELLO:
+        hellos++;
+        break;
+    case AR_LINK_PONG:
+        pongs++;
+        break;
+    case AR_LINK_ACK:
+        acks++;
+        credits++;
+        if (inflight_n == 0 || f.data[0] != inflight[0]) {
+            ack_order_errors++;
+        }
+        if (inflight_n) {
+            memmove(inflight, inflight + 1, --inflight_n);
+        }
+        if (f.data[1] & AR_LINK_ACK_DROPPED) {
+            dropped++;
+        }
+        break;
+    }
+}
+
+// 收完已经到的字节；block 时先等到有字节（可能不够一帧），最多 1 秒
+static void poll_rx(bool block)
+{
+    if (block && sim_uart_wait_rx(SIM_S3, 1000000) == 0) {
+        return;
+    }
+    uint8_t buf[256];
+    int n;
+    while ((n = sim_uart_read(SIM_S3, buf, sizeof(buf))) > 0) {
+        rx.feed(buf, n, on_frame);
+    }
+}
+
+// 第 i 帧的内容：类型在 a/b/c 间轮换，长度在 16 到 915 字节之间变，环里的记录长短交错
+static size_t make_page(char *buf, uint32_t i)
+{
+    size_t len = 16 + i % 900;
+    int n = snprintf(buf, len + 1, "frame %07lu ", (unsigned long)i);
+    for (size_t k = n; k < len; k++) {
+        buf[k] = 'a' + (i + k) % 26;
+    }
+    buf[len] = 0;
+    return len;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+//-----------------------------用例-----------------------------//
+static void test_soak(void)
+{
+    static char page[AR_LINK_MAX_PAYLOAD + 1];
+    static uint8_t out[AR_LINK_HEADER_MAX + AR_LINK_MAX_PAYLOAD + AR_LINK_CRC_LEN];
+    uint8_t seq = 0;
+    uint32_t ping = 0;
+    uint64_t warm_allocs = 0;
+    int64_t warm_peak = 0;
+    // C3 装好驱动以后才发 HELLO，在那之前发的帧对端收不到
+    uint32_t t = millis();
+    while (hellos == 0) {
+        poll_rx(true);
+        TEST_ASSERT_TRUE_MESSAGE(millis() - t < 1000, "C3 1 秒内没有发 HELLO");
+    }
+    uint32_t start = millis();
+    for (uint32_t i = 0; i < SOAK_FRAMES; i++) {
+        t = millis();
+        while (credits == 0) {
+            poll_rx(true);
+            TEST_ASSERT_TRUE_MESSAGE(millis() - t < 1000, "1 秒内没有等到 ACK");
+        }
+        size_t len = make_page(page, i);
+        size_t n = ar_link::encode(out, sizeof(out), 'a' + i % 3, seq, page, len);
+        inflight[inflight_n++] = seq++;
+        credits--;
+        sim_uart_write(SIM_S3, out, n);
+        uint8_t p[4];
+        ar_link::put_u32(p, ping++);
+        n = ar_link::encode(out, sizeof(out), AR_LINK_PING, seq++, p, sizeof(p));
+        sim_uart_write(SIM_S3, out, n);
+        poll_rx(false);
+#if SOAK_HEAP
+        if (i == SOAK_WARMUP) {
+            warm_allocs = heap_allocs.load();
+            warm_peak = heap_peak.load();
+        }
+#endif
+    }
+    t = millis();
+    while (credits < AR_LINK_CREDITS || pongs < ping) {
+        poll_rx(true);                       // 可能只收到半帧，按时间判断
+        TEST_ASSERT_TRUE_MESSAGE(millis() - t < 1000, "最后的 ACK/PONG 1 秒内没有到");
+    }
+    uint32_t ms = millis() - start;
+
+    TEST_ASSERT_EQUAL(SOAK_FRAMES, acks);
+    TEST_ASSERT_EQUAL(0, ack_order_errors);
+    TEST_ASSERT_EQUAL(0, dropped);
+    TEST_ASSERT_EQUAL(ping, pongs);
+    TEST_ASSERT_EQUAL(0, c3_seq_errors);
+    TEST_ASSERT_EQUAL(0, rx.stats().crc_errors);
+    TEST_ASSERT_EQUAL(0, sim_c3_parser_stats().crc_errors);
+    TEST_ASSERT_EQUAL(0, sim_c3_ring_drops());
+    // 最后一帧的类型决定它落在哪个 label 上
+    uint32_t last = SOAK_FRAMES - 1;
+    char text[HOST_LABEL_MAX];
+    page[make_page(page, last)] = 0;
+    host_label_text(sim_c3_label('a' + last % 3), text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING(page, text);
+
+    char msg[200];
+#if SOAK_HEAP
+    uint64_t allocs = heap_allocs.load() - warm_allocs;
+    int64_t peak = heap_peak.load();
+    snprintf(msg, sizeof(msg), "%d 帧 + %lu PING 用了 %lu ms；热身后堆分配 %lu 次，最高水位 %ld -> %ld 字节",
+             SOAK_FRAMES, (unsigned long)ping, (unsigned long)ms, (unsigned long)allocs, (long)warm_peak, (long)peak);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(0, allocs);
+    TEST_ASSERT_EQUAL(warm_peak, peak);
+#else
+    snprintf(msg, sizeof(msg), "%d 帧 + %lu PING 用了 %lu ms；这个 libc 上不数堆", SOAK_FRAMES, (unsigned long)ping, (unsigned long)ms);
+    TEST_MESSAGE(msg);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    sim_uart_throttle(false);                        // 不限速，一百万帧要在几十秒内跑完
+    sim_uart_attach(SIM_S3);
+    sim_c3_start();
+    UNITY_BEGIN();
+    RUN_TEST(test_soak);
+    return UNITY_END();
+}
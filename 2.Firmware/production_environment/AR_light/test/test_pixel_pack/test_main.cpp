@@ -0,0 +1,317 @@
+// 刷屏打包（src/pixel_pack.cpp）的主机测试：
+//   黄金向量  灰阶、彩色、奇数列起止在 PANEL_GRAY 两种模式下的打包结果和散列，图片抖动后的渐变，写死在下面；
+//             改了建表、半字节顺序或者散列，这里会先报出来，确认是有意改的再更新向量
+//   基准测试  pixel_pack_row 和 user-038 之前逐像素改半个字节的写法比速度，两种写法在纯黑白内容上的输出要一致；
+//             整屏再和 user-045、user-038 之前先让 LVGL 软件旋转的写法比。
+//             时间只打印不断言，主机和 C3 差得远，看的是同一台机器上的前后对比。
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include "../../src/pixel_pack.cpp"
+
+#define ROW_W      480               // 面板一行
+#define BAND_ROWS  24                // 和 myoled.h 的 DRAW_BUF_ROWS 一样
+#define BENCH_ROWS 20000
+
+static uint32_t rng = 1;
+static uint32_t rnd()                      // xorshift32，固定种子，每次结果一样
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static lv_color_t gray565(uint8_t v) { return lv_color_make(v, v, v); }
+
+// 白底黑字的一行：白的一段接黑的一段；aa 为 true 时黑白交界处放一个随机灰度的抗锯齿像素
+static void make_text_row(lv_color_t *row, int n, bool aa)
+{
+    int x = 0;
+    while (x < n) {
+        int white = 3 + rnd() % 18, black = 1 + rnd() % 6;
+        for (int i = 0; i < white && x < n; i++) row[x++] = lv_color_white();
+        if (aa && x < n) row[x++] = gray565(rnd() & 0xFF);
+        for (int i = 0; i < black && x < n; i++) row[x++] = lv_color_black();
+        if (aa && x < n) row[x++] = gray565(rnd() & 0xFF);
+    }
+}
+
+// user-038 之前 my_disp_flush 里的写法：每个像素判断一次，读改写半个字节，非黑就是灭，奇数列在高 4 位
+static void old_pack_row(uint8_t *dst, int x, const lv_color_t *src, int n)
+{
+    for (int i = 0; i < n; i++, x++) {
+        uint8_t *b = &dst[(x >> 1)];
+        if (x % 2) {
+            *b = src[i].full ? (*b & 0x0F) : (*b | 0xF0);
+        } else {
+            *b = src[i].full ? (*b & 0xF0) : (*b | 0x0F);
+        }
+    }
+}
+
+static volatile uint32_t sink;
+
+// 两种写法一轮一轮交替跑，各取最快的一轮，少受别的进程和主频变化干扰；结果是每行的纳秒数
+template <class A, class B>
+static void ns_per_row(A &&pack_new, B &&pack_old, double *t_new, double *t_old)
+{
+    *t_new = *t_old = 1e30;
+    for (int round = 0; round < 9; round++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_ROWS; i++) {
+            pack_new(i);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_ROWS; i++) {
+            pack_old(i);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        *t_new = std::min(*t_new, std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_ROWS);
+        *t_old = std::min(*t_old, std::chrono::duration<double, std::nano>(t2 - t1).count() / BENCH_ROWS);
+    }
+}
+
+//-----------------------------黄金向量-----------------------------//
+// 32 级灰阶：亮度 0, 8, 16 ... 248, 255，gamma 2.2
+static void make_ramp(lv_color_t *ramp)
+{
+    for (int i = 0; i < 32; i++) {
+        int v = i == 31 ? 255 : i * 8;
+        ramp[i] = lv_color_make(v, v, v);
+    }
+}
+
+// 红 绿 蓝 黄 青 品红 50% 灰 蓝紫
+static const lv_color_t colors[8] = {
+    lv_color_make(255, 0, 0), lv_color_make(0, 255, 0), lv_color_make(0, 0, 255), lv_color_make(255, 255, 0),
+    lv_color_make(0, 255, 255), lv_color_make(255, 0, 255), lv_color_make(128, 128, 128), lv_color_make(64, 32, 200),
+};
+
+struct pack_golden
+{
+    uint8_t ramp[16];
+    uint32_t ramp_hash;
+    uint8_t odd[10];             // 从第 1 列开始、倒着隔一个取 16 个像素，缓冲原来是 0xA5
+    uint32_t odd_hash;
+    uint8_t colors[4];
+};
+
+static const pack_golden golden[2] = {
+    {   // PANEL_GRAY 0：亮度低于一半的点亮
+        {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+        0x4E84D8FD,
+        {0x05, 0x00, 0x00, 0x00, 0xF0, 0xFF, 0xFF, 0xFF, 0xAF, 0xA5},
+        0xC0F6A91B,
+        {0x0F, 0x0F, 0xF0, 0xF0},
+    },
+    {   // PANEL_GRAY 1：16 级，反相加 gamma
+        {0xEF, 0xCD, 0xAB, 0x9A, 0x78, 0x67, 0x55, 0x44, 0x33, 0x22, 0x12, 0x11, 0x01, 0x00, 0x00, 0x00},
+        0x5AC4B829,
+        {0x05, 0x00, 0x10, 0x21, 0x43, 0x65, 0x97, 0xCA, 0xAE, 0xA5},
+        0x02666133,
+        {0x27, 0x0C, 0x51, 0x83},
+    },
+};
+
+// 64x4 的亮度渐变（亮度 x*255/63，不反相）经过 pixel_dither 后按面板格式打包
+static const uint8_t golden_dither[4][32] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x11, 0x11, 0x21, 0x21, 0x22, 0x32, 0x33,
+     0x43, 0x43, 0x54, 0x55, 0x65, 0x76, 0x76, 0x87, 0x98, 0xA9, 0xA9, 0xBA, 0xCB, 0xDC, 0xED, 0xFE},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x11, 0x11, 0x11, 0x11, 0x22, 0x22, 0x23, 0x23, 0x33,
+     0x34, 0x44, 0x45, 0x55, 0x66, 0x67, 0x77, 0x88, 0x89, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x10, 0x11, 0x21, 0x21, 0x22, 0x22, 0x32, 0x33,
+     0x43, 0x43, 0x54, 0x54, 0x65, 0x76, 0x77, 0x87, 0x98, 0x99, 0xAA, 0xBA, 0xCB, 0xDC, 0xED, 0xFE},
+    {0x00, 0x00, 0x01, 0x00, 0x01, 0x01, 0x01, 0x01, 0x11, 0x11, 0x12, 0x12, 0x22, 0x22, 0x33, 0x33,
+     0x44, 0x44, 0x55, 0x55, 0x66, 0x66, 0x77, 0x88, 0x99, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF},
+};
+
+// 和 pixel_pack.cpp 无关的参考：RGB565 按同样的整数系数算亮度，再用浮点做反相和 gamma
+static int ref_nib(lv_color_t c, bool gray)
+{
+    int r = c.ch.red * 255 / 31, g = c.ch.green * 255 / 63, b = c.ch.blue * 255 / 31;
+    int luma = (r * 77 >> 8) + (g * 150 >> 8) + (b * 29 >> 8);
+    if (!gray) {
+        return 255 - luma >= 128 ? 0x0F : 0x00;
+    }
+    return (int)(pow((255 - luma) / 255.0, 2.2) * 15.0 + 0.5);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+//-----------------------------用例-----------------------------//
+static void test_binary_matches_old(void)
+{
+    pixel_pack_init(2.2f, false);
+    static lv_color_t row[ROW_W];
+    static uint8_t a[ROW_W / 2], b[ROW_W / 2];
+    for (int k = 0; k < 2000; k++) {
+        make_text_row(row, ROW_W, false);
+        int x = rnd() % ROW_W, n = rnd() % (ROW_W - x + 1);
+        memset(a, 0x5A, sizeof(a));
+        memset(b, 0x5A, sizeof(b));
+        pixel_pack_row(a + x / 2, x, row, 1, n);
+        old_pack_row(b, x, row, n);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(b, a, sizeof(a));
+    }
+}
+
+static void test_golden_pack(void)
+{
+    lv_color_t ramp[32];
+    make_ramp(ramp);
+    for (int gray = 0; gray < 2; gray++) {
+        pixel_pack_init(2.2f, gray);
+        const pack_golden &g = golden[gray];
+        uint8_t out[16];
+        TEST_ASSERT_EQUAL_HEX32(g.ramp_hash, pixel_pack_row(out, 0, ramp, 1, 32));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(g.ramp, out, sizeof(out));
+        for (int i = 0; i < 32; i++) {
+            TEST_ASSERT_EQUAL(ref_nib(ramp[i], gray), pixel_nib(out[i / 2], i));
+        }
+        // 奇数列开头只改奇数列那半个字节，结尾落在半个字节上只改偶数列那半个，其余字节不碰
+        uint8_t odd[10];
+        memset(odd, 0xA5, sizeof(odd));
+        TEST_ASSERT_EQUAL_HEX32(g.odd_hash, pixel_pack_row(odd, 1, ramp + 31, -2, 16));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(g.odd, odd, sizeof(odd));
+        uint8_t col[4];
+        pixel_pack_row(col, 0, colors, 1, 8);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(g.colors, col, sizeof(col));
+        for (int i = 0; i < 8; i++) {
+            TEST_ASSERT_EQUAL(ref_nib(colors[i], gray), pixel_nib(col[i / 2], i));
+        }
+    }
+}
+
+static void test_golden_dither(void)
+{
+    pixel_pack_init(2.2f, true);
+    for (int y = 0; y < 4; y++) {
+        uint8_t row[32];
+        for (int x = 0; x < 64; x += 2) {
+            row[x / 2] = pixel_pair(pixel_dither(x * 255 / 63, x, y), pixel_dither((x + 1) * 255 / 63, x + 1, y));
+        }
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(golden_dither[y], row, sizeof(row));
+    }
+    // 每个亮度铺满一个 4x4 抖动块，平均灰度要接近 gamma 之后的目标，说明 16 级之间的差确实被摊开了
+    double worst = 0;
+    for (int luma = 0; luma < 256; luma++) {
+        int sum = 0;
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                sum += pixel_dither(luma, x, y);
+            }
+        }
+        double err = fabs(sum / 16.0 - pow(luma / 255.0, 2.2) * 15.0);
+        if (err > worst) worst = err;
+    }
+    char msg[80];
+    snprintf(msg, sizeof(msg), "抖动块平均灰度和目标最大差 %.3f 级", worst);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE_MESSAGE(worst < 0.04, "抖动块平均灰度偏离 gamma 目标");
+}
+
+static void test_bench_row(void)
+{
+    static lv_color_t rows[3][64][ROW_W];
+    static uint8_t out[ROW_W / 2];
+    const char *names[3] = {"空白行", "黑白文字", "抗锯齿文字"};
+    for (int i = 0; i < 64; i++) {
+        for (int x = 0; x < ROW_W; x++) rows[0][i][x] = lv_color_white();
+        make_text_row(rows[1][i], ROW_W, false);
+        make_text_row(rows[2][i], ROW_W, true);
+    }
+    for (int gray = 0; gray < 2; gray++) {
+        pixel_pack_init(2.2f, gray);
+        for (int c = 0; c < 3; c++) {
+            double t_new, t_old;
+            ns_per_row([&](int i) { sink += pixel_pack_row(out, 0, rows[c][i & 63], 1, ROW_W); },
+                       [&](int i) {
+                           old_pack_row(out, 0, rows[c][i & 63], ROW_W);
+                           sink += out[i % (ROW_W / 2)];
+                       },
+                       &t_new, &t_old);
+            char msg[160];
+            snprintf(msg, sizeof(msg), "PANEL_GRAY=%d %s %d 像素: pixel_pack_row %.0f ns，原来逐像素 %.0f ns，%.2f 倍",
+                     gray, names[c], ROW_W, t_new, t_old, t_old / t_new);
+            TEST_MESSAGE(msg);
+        }
+    }
+}
+
+// 整屏 480x480 按 24 行一块刷，每种写法一轮：
+//   现在      旋转和打包一起做（步长 -w）
+//   045 之前  LVGL 软件旋转（lv_refr.c 的 draw_buf_rotate_270，逐像素转到另一块缓冲）再 pixel_pack_row
+//   038 之前  LVGL 软件旋转再逐像素打包（只分黑白，活比现在少）
+//   只打包    038 之前去掉旋转那一遍，只是参照
+static void test_bench_frame(void)
+{
+    static lv_color_t band[BAND_ROWS * ROW_W];
+    static lv_color_t rot[BAND_ROWS * ROW_W];
+    static uint8_t out[ROW_W / 2];
+    for (int y = 0; y < BAND_ROWS; y++) {
+        make_text_row(band + y * ROW_W, ROW_W, true);
+    }
+    pixel_pack_init(2.2f, true);
+    const int bands = ROW_W / BAND_ROWS;
+    auto sw_rotate = [&]() {
+        for (int y = 0; y < BAND_ROWS; y++) {
+            for (int x = 0; x < ROW_W; x++) {
+                rot[x * BAND_ROWS + BAND_ROWS - 1 - y] = band[y * ROW_W + x];
+            }
+        }
+    };
+    auto frame = [&](int way) {
+        for (int b = 0; b < bands; b++) {
+            if (way == 0) {
+                const lv_color_t *col = band + (BAND_ROWS - 1) * ROW_W;
+                for (int x = 0; x < ROW_W; x++, col++) {
+                    sink += pixel_pack_row(out, 0, col, -ROW_W, BAND_ROWS);
+                }
+            } else if (way == 1) {
+                sw_rotate();
+                for (int x = 0; x < ROW_W; x++) {
+                    sink += pixel_pack_row(out, 0, rot + x * BAND_ROWS, 1, BAND_ROWS);
+                }
+            } else if (way == 2) {
+                sw_rotate();
+                for (int x = 0; x < ROW_W; x++) {
+                    old_pack_row(out, 0, rot + x * BAND_ROWS, BAND_ROWS);
+                    sink += out[x % (BAND_ROWS / 2)];
+                }
+            } else {
+                for (int y = 0; y < BAND_ROWS; y++) {
+                    old_pack_row(out, 0, band + y * ROW_W, ROW_W);
+                    sink += out[y];
+                }
+            }
+        }
+    };
+    double t[4] = {1e30, 1e30, 1e30, 1e30};
+    for (int round = 0; round < 20; round++) {
+        for (int way = 0; way < 4; way++) {
+            auto t0 = std::chrono::steady_clock::now();
+            frame(way);
+            auto t1 = std::chrono::steady_clock::now();
+            t[way] = std::min(t[way], std::chrono::duration<double, std::micro>(t1 - t0).count());
+        }
+    }
+    char msg[240];
+    snprintf(msg, sizeof(msg), "整屏 480x480 抗锯齿文字: 旋转+打包 %.0f us；045 之前 LVGL 软件旋转+pixel_pack_row %.0f us（%.2f 倍）；"
+             "038 之前 LVGL 软件旋转+逐像素打包 %.0f us；只打包 %.0f us",
+             t[0], t[1], t[1] / t[0], t[2], t[3]);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_golden_pack);
+    RUN_TEST(test_golden_dither);
+    RUN_TEST(test_binary_matches_old);
+    RUN_TEST(test_bench_row);
+    RUN_TEST(test_bench_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,517 @@
+/*
+ * @Description: S3(AR_glass) 与 C3(AR_light) 之间的串口帧协议，两个工程共用，只有头文件
+ *
+ * 帧格式：
+ *   sync   2 byte     0xA5 0x5A
+ *   type   1 byte     命令，沿用原来的 'a'~'k' 命令表
+ *   seq    1 byte     发送序号，每帧加 1
+ *   len    1~3 byte   数据长度，varint（LEB128，低 7 位在前）
+ *   data   len byte   数据
+ *   crc    2 byte     CRC16-CCITT（type 到 data 结束），低字节在前
+ *
+ * 解析器把收到的字节缓存在固定大小的缓冲里，CRC 或长度错误时只丢掉一个字节，
+ * 然后从下一个同步字重新开始找帧，所以坏帧里面夹着的好帧也能找回来。
+ */
+#ifndef AR_LINK_H
+#define AR_LINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define AR_LINK_SYNC0       0xA5
+#define AR_LINK_SYNC1       0x5A
+#define AR_LINK_HEADER_MAX  7      // sync(2) + type(1) + seq(1) + len(最多 3)
+#define AR_LINK_CRC_LEN     2
+
+#ifndef AR_LINK_MAX_PAYLOAD
+#define AR_LINK_MAX_PAYLOAD 1024   // 单帧数据上限，超过的长度一律当作坏帧
+#endif
+
+//---------------------链路控制命令，0x80 以上，和显示命令分开---------------------//
+#define AR_LINK_HELLO       0x80   // C3 上电后以默认波特率发送
+#define AR_LINK_BAUD_REQ    0x81   // S3->C3  data: u32 新波特率
+#define AR_LINK_BAUD_ACK    0x82   // C3->S3  data: u32 新波特率，发完后 C3 切换
+#define AR_LINK_PING        0x83   // S3->C3  data: u32 序号 + 填充
+#define AR_LINK_PONG        0x84   // C3->S3  原样返回 PING 的数据
+#define AR_LINK_ACK         0x85   // C3->S3  显示帧已渲染（或被丢弃），归还一个信用，格式见下
+
+// ACK 数据：seq(1) + flags(1) + 排队 us(u32，收到->应用) + 渲染 us(u32，应用->刷到屏上)
+#define AR_LINK_ACK_LEN        10
+#define AR_LINK_ACK_DROPPED    0x01   // C3 放不下，帧被丢弃
+#define AR_LINK_CREDITS        3      // S3 最多有这么多个显示帧没收到 ACK，C3 的帧环按这个大小准备
+#define AR_LINK_ACK_TIMEOUT_MS 500    // 有帧在途却这么久没有 ACK，当作链路出错
+
+#define AR_LINK_BAUD_DEFAULT  115200
+#ifndef AR_LINK_BAUD_MAX
+#define AR_LINK_BAUD_MAX      2000000     // 协商的上限，板子走线不好时可以调低
+#endif
+#define AR_LINK_BAUD_RATES    {2000000, 1000000, 921600, 460800}   // 协商时从高到低尝试
+#define AR_LINK_PROBATION_MS  300   // 切换波特率后这么久没收到好帧就退回默认波特率
+#define AR_LINK_GARBAGE_MS    200   // 非默认波特率下持续只收到乱码这么久就退回默认波特率
+
+// C3 空闲时进自动浅睡眠，靠 RX 线上的边沿唤醒，唤醒过程中收到的字节会丢掉。
+// 链路空闲超过 AR_LINK_WAKE_IDLE_MS 后 S3 先发一段唤醒字节，长度够 C3 醒过来，再发帧；
+// 唤醒字节里没有同步字，醒着的 C3 收到了也只是当作帧间的杂字节跳过
+#define AR_LINK_WAKE_BYTE     0x55  // 每个字节 5 个上升沿
+#define AR_LINK_WAKE_EDGES    3     // C3 收到这么多个上升沿就醒（uart_set_wakeup_threshold）
+#define AR_LINK_WAKE_IDLE_MS  10    // 发送端空闲这么久就当 C3 可能睡了；C3 收到数据后至少醒这么久（LINK_RX_AWAKE_MS）
+#define AR_LINK_WAKE_US       1000  // C3 从浅睡眠醒来、串口时钟恢复需要的时间，留足余量
+
+namespace ar_link {
+
+inline void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 唤醒字节的个数：按波特率覆盖 AR_LINK_WAKE_US（每字节 10 位），至少能凑够唤醒的边沿数
+inline size_t wake_len(uint32_t baud)
+{
+    return baud / 10 * AR_LINK_WAKE_US / 1000000 + 1;
+}
+
+inline bool baud_supported(uint32_t baud)
+{
+    static const uint32_t rates[] = AR_LINK_BAUD_RATES;
+    if (baud == AR_LINK_BAUD_DEFAULT) return true;
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (rates[i] == baud) return baud <= AR_LINK_BAUD_MAX;
+    }
+    return false;
+}
+
+// CRC16-CCITT，多项式 0x1021，初值 0xFFFF，半字节查表
+inline uint16_t crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+        0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    };
+    while (len--) {
+        uint8_t b = *data++;
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (b >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (b & 0x0f)]);
+    }
+    return crc;
+}
+
+struct Frame {
+    uint8_t type;
+    uint8_t seq;
+    const uint8_t *data;   // 指向解析器内部缓冲，只在回调期间有效
+    size_t len;
+};
+
+// 写帧头，返回帧头长度（不超过 AR_LINK_HEADER_MAX）
+inline size_t encode_header(uint8_t *out, uint8_t type, uint8_t seq, size_t len)
+{
+    size_t n = 0;
+    out[n++] = AR_LINK_SYNC0;
+    out[n++] = AR_LINK_SYNC1;
+    out[n++] = type;
+    out[n++] = seq;
+    do {
+        uint8_t b = len & 0x7f;
+        len >>= 7;
+        out[n++] = len ? (b | 0x80) : b;
+    } while (len && n < AR_LINK_HEADER_MAX);
+    return n;
+}
+
+// 帧尾 CRC，header 为 encode_header 的输出
+inline uint16_t frame_crc(const uint8_t *header, size_t header_len, const void *data, size_t len)
+{
+    uint16_t crc = crc16(0xFFFF, header + 2, header_len - 2);
+    return crc16(crc, (const uint8_t *)data, len);
+}
+
+// 整帧编码到 out，返回总长度；cap 不够时返回 0
+inline size_t encode(uint8_t *out, size_t cap, uint8_t type, uint8_t seq, const void *data, size_t len)
+{
+    uint8_t header[AR_LINK_HEADER_MAX];
+    size_t hlen = encode_header(header, type, seq, len);
+    if (hlen + len + AR_LINK_CRC_LEN > cap) {
+        return 0;
+    }
+    uint16_t crc = frame_crc(header, hlen, data, len);
+    memcpy(out, header, hlen);
+    memcpy(out + hlen, data, len);
+    out[hlen + len] = (uint8_t)crc;
+    out[hlen + len + 1] = (uint8_t)(crc >> 8);
+    return hlen + len + AR_LINK_CRC_LEN;
+}
+
+//---------------------屏幕状态帧 'l'：多个字段一次发送---------------------//
+// data 由若干字段组成：tag(1) + len(2，低字节在前) + 内容(len) + '\0'
+// tag 沿用单字段命令的字母（'a' 内容、'b' 页码、'c' 文件名、'i' 进度条），
+// 内容后面多带一个 '\0'，接收端可以直接把内容当 C 字符串用。
+#define AR_LINK_SCREEN      'l'
+
+// 往 out 里追加一个字段，返回新的长度；放不下时不写，返回原长度
+inline size_t tlv_put(uint8_t *out, size_t pos, size_t cap, uint8_t tag, const void *data, size_t len)
+{
+    if (len > 0xffff || pos + 3 + len + 1 > cap) {
+        return pos;
+    }
+    out[pos] = tag;
+    out[pos + 1] = (uint8_t)len;
+    out[pos + 2] = (uint8_t)(len >> 8);
+    memcpy(out + pos + 3, data, len);
+    out[pos + 3 + len] = '\0';
+    return pos + 3 + len + 1;
+}
+
+// 从 *pos 开始取下一个字段，取完或格式不对返回 false
+inline bool tlv_next(const uint8_t *data, size_t len, size_t *pos, uint8_t *tag, const uint8_t **value, size_t *value_len)
+{
+    size_t p = *pos;
+    if (p + 3 > len) {
+        return false;
+    }
+    size_t n = data[p + 1] | (data[p + 2] << 8);
+    if (p + 3 + n + 1 > len || data[p + 3 + n] != '\0') {
+        return false;
+    }
+    *tag = data[p];
+    *value = data + p + 3;
+    *value_len = n;
+    *pos = p + 3 + n + 1;
+    return true;
+}
+
+//---------------------图片帧：'m' 开始 + 若干 'n' 数据---------------------//
+// 'c'/'d'/'e' 早就被文件名、时间、蓝牙状态占用了，图片用新的命令字母。
+// 'm' data：格式(1) + x(2) + y(2) + w(2) + h(2) + 总字节数(4)，多字节都是低字节在前，
+//           坐标是 LVGL 的逻辑坐标（旋转前），JPEG/PNG 的 w/h 可以填 0，以文件头为准
+// 'n' data：图片文件的下一段，按顺序发完总字节数为止
+#define AR_LINK_IMG_BEGIN   'm'
+#define AR_LINK_IMG_DATA    'n'
+#define AR_LINK_IMG_HDR_LEN 13
+
+#define AR_LINK_IMG_RGB565  0      // 原始 RGB565，每像素 2 字节，高字节在前（和摄像头输出一致）
+#define AR_LINK_IMG_JPEG    1
+#define AR_LINK_IMG_PNG     2      // 只支持 8 bit 深度、不隔行
+#define AR_LINK_IMG_CLEAR   0xff   // 不带数据，清掉图片，整屏按 LVGL 重绘
+
+inline void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+//---------------------显示列表帧 'o'：S3 排好版，C3 照着画---------------------//
+// data 是若干条绘制指令，一帧整个替换上一帧；坐标是 LVGL 的逻辑坐标（旋转前），多字节都是低字节在前。
+//   AR_DL_TEXT  op x(2) y(2) w(2) align(1) n(1) + n 个码点(各 2 字节，只支持 BMP)
+//               一行字，y 是行顶；居中/右对齐时在 [x, x+w) 里对齐，C3 只累加字宽，不断行不排版
+//   AR_DL_RECT  op x(2) y(2) w(2) h(2) radius(1) lit(1)   lit 非 0 点亮，0 熄灭（擦掉一块）
+//   AR_DL_BAR   op x(2) y(2) w(2) h(2) value(1)           进度条：圆角外框 + 按 value(0~100) 填充
+// 空的 'o' 帧清掉显示列表，C3 恢复用 label 显示正文。
+// 可以单独发，也可以作为屏幕状态帧 'l' 的一个字段，和页码、文件名一起在同一次刷新里生效。
+#define AR_LINK_DLIST       'o'
+
+#define AR_DL_TEXT          1
+#define AR_DL_RECT          2
+#define AR_DL_BAR           3
+
+#define AR_DL_ALIGN_LEFT    0
+#define AR_DL_ALIGN_CENTER  1
+#define AR_DL_ALIGN_RIGHT   2
+
+#define AR_DL_TEXT_HDR      9
+#define AR_DL_RECT_LEN      11
+#define AR_DL_BAR_LEN       10
+#define AR_DL_TEXT_MAX      255    // 一条 TEXT 最多的码点数
+
+// 解出来的一条指令，cps 指向帧里的码点（未对齐，用 get_u16 读）
+struct DlOp {
+    uint8_t op;
+    int16_t x, y;
+    uint16_t w, h;
+    uint8_t arg;             // TEXT: align  RECT: radius  BAR: value
+    uint8_t lit;             // RECT
+    uint8_t n;               // TEXT: 码点数
+    const uint8_t *cps;
+};
+
+// 解一个 UTF-8 字符，返回占用的字节数，遇到非法字节返回 1 并给出 U+FFFD
+inline size_t utf8_decode(const uint8_t *s, size_t len, uint32_t *cp)
+{
+    uint8_t c = s[0];
+    size_t n = c < 0x80 ? 1 : (c & 0xe0) == 0xc0 ? 2 : (c & 0xf0) == 0xe0 ? 3 : (c & 0xf8) == 0xf0 ? 4 : 0;
+    if (n == 0 || n > len) {
+        *cp = 0xfffd;
+        return 1;
+    }
+    uint32_t v = n == 1 ? c : c & (0x7f >> n);
+    for (size_t i = 1; i < n; i++) {
+        if ((s[i] & 0xc0) != 0x80) {
+            *cp = 0xfffd;
+            return 1;
+        }
+        v = (v << 6) | (s[i] & 0x3f);
+    }
+    *cp = v;
+    return n;
+}
+
+// 追加一条 TEXT，文字是 UTF-8，超出 BMP 的字符换成 U+FFFD；放不下时不写，返回原长度
+inline size_t dl_text(uint8_t *out, size_t pos, size_t cap, int x, int y, int w, uint8_t align, const char *utf8, size_t len)
+{
+    if (pos + AR_DL_TEXT_HDR > cap) {
+        return pos;
+    }
+    size_t p = pos + AR_DL_TEXT_HDR;
+    size_t n = 0;
+    for (size_t i = 0; i < len && n < AR_DL_TEXT_MAX;) {
+        uint32_t cp;
+        i += utf8_decode((const uint8_t *)utf8 + i, len - i, &cp);
+        if (p + 2 > cap) {
+            return pos;
+        }
+        put_u16(out + p, cp > 0xffff ? 0xfffd : (uint16_t)cp);
+        p += 2;
+        n++;
+    }
+    out[pos] = AR_DL_TEXT;
+    put_u16(out + pos + 1, (uint16_t)x);
+    put_u16(out + pos + 3, (uint16_t)y);
+    put_u16(out + pos + 5, (uint16_t)w);
+    out[pos + 7] = align;
+    out[pos + 8] = (uint8_t)n;
+    return p;
+}
+
+inline size_t dl_rect(uint8_t *out, size_t pos, size_t cap, int x, int y, int w, int h, uint8_t radius, bool lit)
+{
+    if (pos + AR_DL_RECT_LEN > cap) {
+        return pos;
+    }
+    out[pos] = AR_DL_RECT;
+    put_u16(out + pos + 1, (uint16_t)x);
+    put_u16(out + pos + 3, (uint16_t)y);
+    put_u16(out + pos + 5, (uint16_t)w);
+    put_u16(out + pos + 7, (uint16_t)h);
+    out[pos + 9] = radius;
+    out[pos + 10] = lit ? 1 : 0;
+    return pos + AR_DL_RECT_LEN;
+}
+
+inline size_t dl_bar(uint8_t *out, size_t pos, size_t cap, int x, int y, int w, int h, int value)
+{
+    if (pos + AR_DL_BAR_LEN > cap) {
+        return pos;
+    }
+    out[pos] = AR_DL_BAR;
+    put_u16(out + pos + 1, (uint16_t)x);
+    put_u16(out + pos + 3, (uint16_t)y);
+    put_u16(out + pos + 5, (uint16_t)w);
+    put_u16(out + pos + 7, (uint16_t)h);
+    out[pos + 9] = (uint8_t)(value < 0 ? 0 : value > 100 ? 100 : value);
+    return pos + AR_DL_BAR_LEN;
+}
+
+// 从 *pos 开始取下一条指令，取完或格式不对返回 false
+inline bool dl_next(const uint8_t *data, size_t len, size_t *pos, DlOp *op)
+{
+    size_t p = *pos;
+    if (p >= len) {
+        return false;
+    }
+    const uint8_t *d = data + p;
+    size_t n;
+    switch (d[0]) {
+    case AR_DL_TEXT:
+        if (p + AR_DL_TEXT_HDR > len) return false;
+        n = AR_DL_TEXT_HDR + d[8] * 2;
+        break;
+    case AR_DL_RECT: n = AR_DL_RECT_LEN; break;
+    case AR_DL_BAR:  n = AR_DL_BAR_LEN; break;
+    default:         return false;
+    }
+    if (p + n > len) {
+        return false;
+    }
+    op->op = d[0];
+    op->x = (int16_t)get_u16(d + 1);
+    op->y = (int16_t)get_u16(d + 3);
+    op->w = get_u16(d + 5);
+    op->h = d[0] == AR_DL_TEXT ? 0 : get_u16(d + 7);
+    op->arg = d[0] == AR_DL_TEXT ? d[7] : d[9];
+    op->lit = d[0] == AR_DL_RECT ? d[10] : 0;
+    op->n = d[0] == AR_DL_TEXT ? d[8] : 0;
+    op->cps = d + AR_DL_TEXT_HDR;
+    *pos = p + n;
+    return true;
+}
+
+//---------------------字形：C3 缺字时向 S3 要，S3 从 SD 卡的字库里取---------------------//
+// C3 固件里的字体只是常用字子集，没有的字由 S3 从 SD 卡上的完整字库（格式见 AR_glass/src/my_glyph.h）取出发过来。
+//   0x88 GLYPH_REQ  C3->S3  若干个码点(各 2 字节)，不占信用，S3 的字形任务查 SD 后用 'p' 回复
+//   'p'  GLYPH      S3->C3  若干条字形记录，普通显示帧（占信用、按顺序），C3 放进 LRU 字形缓存
+//   'q'  GLYPH_SET  S3->C3  下一页要用到的非 ASCII 码点(各 2 字节)，C3 把缺的一次性要过来，翻页时就不用等了
+// 字形记录：码点(2) + 字宽(1) + box_w(1) + box_h(1) + ofs_x(1，有符号) + ofs_y(1，有符号) + 位图
+// 位图是 4 bpp，高 4 位在前，行与行之间不补齐（和 LVGL 的字体位图一样），共 (box_w*box_h+1)/2 字节。
+// 字库里也没有的字回一条 box_w = box_h = 0、字宽为 0 的记录，C3 记下来不再要。
+#define AR_LINK_GLYPH_REQ   0x88
+#define AR_LINK_GLYPH       'p'
+#define AR_LINK_GLYPH_SET   'q'
+
+#define AR_GLYPH_HDR        7
+#define AR_GLYPH_BOX_MAX    32     // 字形边长上限，更大的当作坏记录
+
+inline size_t glyph_bitmap_len(uint8_t box_w, uint8_t box_h)
+{
+    return ((size_t)box_w * box_h + 1) / 2;
+}
+
+//---------------------面板温度：C3 的温控上报---------------------//
+//   0x89 THERMAL  C3->S3  不占信用。温度、亮度、电流或降档级别变了就发，没变也至少每 AR_LINK_THERMAL_MS 发一次
+// 格式：温度(2，有符号，0.1 ℃，没读到为 AR_THERMAL_NONE) + 亮度寄存器(2) + 电流寄存器(1) + 降档级别(1，0 不降)
+#define AR_LINK_THERMAL     0x89
+#define AR_LINK_THERMAL_LEN 6
+#define AR_LINK_THERMAL_MS  30000
+#define AR_THERMAL_NONE     ((int16_t)0x8000)
+
+//---------------------显示基准测试：S3 要求，C3 跑一组固定场景---------------------//
+//   0x8A BENCH_REQ     S3->C3  不带数据，不占信用。C3 在 loop() 里把各个场景依次跑完（这几秒里不处理显示帧），再逐个回报
+//   0x8B BENCH_RESULT  C3->S3  一个场景一帧，不占信用
+// 格式：场景(1) + 帧数(2) + 总时间(4) + 绘制(4) + 打包(4) + SPI(4) + 等 SYNC(4) + 字节数(4)，时间都是 us，全部帧的合计。
+// 场景和内容固定在 C3 固件里，改显示路径前后各跑一次对比。
+#define AR_LINK_BENCH_REQ    0x8A
+#define AR_LINK_BENCH_RESULT 0x8B
+#define AR_LINK_BENCH_LEN    27
+
+#define AR_BENCH_CJK         0     // 整页中文，每帧换一页
+#define AR_BENCH_BAR         1     // 进度条每帧走一格
+#define AR_BENCH_CLOCK       2     // 时钟每帧跳一下
+#define AR_BENCH_IMAGE       3     // RGB565 图片走 'm'/'n' 同一条解码写屏路径
+#define AR_BENCH_SCROLL      4     // 整页中文每帧上移几行像素
+#define AR_BENCH_SCENES      5
+#define AR_BENCH_NAMES       {"cjk", "bar", "clock", "image", "scroll"}
+
+struct ParserStats {
+    uint32_t frames;        // 解析成功的帧
+    uint32_t crc_errors;    // CRC 错误
+    uint32_t len_errors;    // 长度字段非法
+    uint32_t resyncs;       // 丢字节后重新对上帧的次数
+    uint32_t skipped;       // 丢掉的字节数
+};
+
+// 流式解析器：feed() 可以一次喂任意多个字节，每解析出一帧调用一次 on_frame(const Frame &)
+template <size_t MaxPayload = AR_LINK_MAX_PAYLOAD>
+class Parser {
+public:
+    template <typename F>
+    void feed(const uint8_t *data, size_t n, F &&on_frame)
+    {
+        while (n > 0) {
+            size_t k = sizeof(buf_) - len_;
+            if (k > n) k = n;
+            memcpy(buf_ + len_, data, k);
+            len_ += k;
+            data += k;
+            n -= k;
+            parse(on_frame);
+        }
+    }
+
+    void reset() { len_ = 0; lost_ = false; }
+    const ParserStats &stats() const { return stats_; }
+
+private:
+    enum Result { NEED_MORE, BAD_LEN, BAD_CRC, OK };
+
+    uint8_t buf_[AR_LINK_HEADER_MAX + MaxPayload + AR_LINK_CRC_LEN];
+    size_t len_ = 0;
+    bool lost_ = false;                             // 上一个好帧之后丢过字节
+    ParserStats stats_ = {};
+
+    Result parse_at(size_t pos, Frame *f, size_t *frame_len)
+    {
+        const uint8_t *p = buf_ + pos;
+        size_t avail = len_ - pos;
+        size_t i = 4;
+        size_t len = 0;
+        for (int shift = 0;; shift += 7) {
+            if (i >= avail) return NEED_MORE;
+            if (i >= AR_LINK_HEADER_MAX) return BAD_LEN;
+            uint8_t b = p[i++];
+            len |= (size_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) break;
+        }
+        if (len > MaxPayload) return BAD_LEN;
+        if (avail < i + len + AR_LINK_CRC_LEN) return NEED_MORE;
+
+        uint16_t crc = crc16(0xFFFF, p + 2, i - 2 + len);
+        if (crc != (uint16_t)(p[i + len] | (p[i + len + 1] << 8))) return BAD_CRC;
+
+        f->type = p[2];
+        f->seq = p[3];
+        f->data = p + i;
+        f->len = len;
+        *frame_len = i + len + AR_LINK_CRC_LEN;
+        return OK;
+    }
+
+    template <typename F>
+    void parse(F &on_frame)
+    {
+        size_t pos = 0;
+        for (;;) {
+            size_t start = pos;
+            while (pos + 1 < len_ && !(buf_[pos] == AR_LINK_SYNC0 && buf_[pos + 1] == AR_LINK_SYNC1)) {
+                pos++;
+            }
+            if (pos + 1 >= len_ && pos < len_ && buf_[pos] != AR_LINK_SYNC0) {
+                pos++;                              // 最后一个字节不可能是同步字开头
+            }
+            if (pos != start) {
+                stats_.skipped += pos - start;
+                lost_ = true;
+            }
+            if (pos + 1 >= len_) break;
+
+            Frame f;
+            size_t frame_len;
+            Result r = parse_at(pos, &f, &frame_len);
+            if (r == NEED_MORE) break;
+            if (r != OK) {
+                if (r == BAD_CRC) stats_.crc_errors++;
+                else stats_.len_errors++;
+                pos++;                              // 只丢一个字节，从后面继续找同步字
+                stats_.skipped++;
+                lost_ = true;
+                continue;
+            }
+            if (lost_) {
+                stats_.resyncs++;
+                lost_ = false;
+            }
+            stats_.frames++;
+            on_frame(f);
+            pos += frame_len;
+        }
+        if (pos > 0) {
+            len_ -= pos;
+            memmove(buf_, buf_ + pos, len_);
+        }
+    }
+};
+
+}  // namespace ar_link
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * @Description: 串口链路的进程内模拟，给在 Linux 上跑两端协议代码用，只有头文件
+ *
+ * SimPipe 模拟一个方向的串口线：
+ *   - 按波特率限速，每字节 10 bit（8N1），写入的字节排队，线上同一时间只能发一个；baud 为 0 时不限速
+ *   - 每帧之间可以加随机抖动（模拟对端发送任务被抢占）
+ *   - 可以按概率丢字节、翻转一个 bit，用来验证解析器的重同步
+ *   - 接收端波特率（rx_baud）和发送端不一样时收到的都是乱码，模拟一端切了波特率另一端还没切
+ *   - 线上加接收缓冲最多积压 AR_LINK_SIM_BUF 字节，满了再写的算溢出丢掉，全程不申请内存
+ * 时间由调用者推进（now_us），不依赖线程和真实时钟，同样的 seed 结果完全可复现。
+ *
+ * 用法：
+ *   ar_link::SimLink link(2000000);               // 一对方向，2Mbaud
+ *   link.s3_to_c3.cfg.loss_ppm = 100;              // 每百万字节丢 100 个
+ *   link.s3_to_c3.write(buf, n, now_us);           // S3 发送
+ *   n = link.s3_to_c3.read(out, cap, now_us);      // C3 读到 now_us 为止已经到达的字节
+ * 两端的 my_uart.cpp 在主机上编译时，把 uart_write_bytes / uart_read_bytes 换成上面两个调用即可
+ * （AR_light/test/host/driver/uart.h 就是这么做的）。
+ */
+#ifndef AR_LINK_SIM_H
+#define AR_LINK_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef AR_LINK_SIM_BUF
+#define AR_LINK_SIM_BUF 16384      // 要是 2 的幂
+#endif
+
+namespace ar_link {
+
+struct SimConfig {
+    uint32_t baud = 115200;        // 发送端波特率，0 表示不限速
+    uint32_t rx_baud = 0;          // 接收端波特率，0 表示和发送端一样
+    uint32_t jitter_us = 0;        // 每次 write 开始前随机延迟 0~jitter_us
+    uint32_t loss_ppm = 0;         // 每百万字节丢掉的个数
+    uint32_t flip_ppm = 0;         // 每百万字节翻转一个 bit 的个数
+    uint32_t seed = 1;
+};
+
+struct SimPipeStats {
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint32_t lost;
+    uint32_t flipped;
+    uint32_t garbled;              // 波特率对不上收成乱码的字节
+    uint32_t overrun;              // 积压超过 AR_LINK_SIM_BUF 丢掉的字节
+};
+
+class SimPipe {
+public:
+    SimConfig cfg;
+
+    explicit SimPipe(uint32_t baud = 115200) { cfg.baud = baud; rng_ = cfg.seed; }
+
+    void reseed() { rng_ = cfg.seed ? cfg.seed : 1; }
+
+    // 写入 n 字节，从 now_us（加抖动）或者线上上一个字节发完之后开始发
+    void write(const uint8_t *data, size_t n, uint64_t now_us)
+    {
+        uint64_t t = now_us + (cfg.jitter_us ? next() % (cfg.jitter_us + 1) : 0);
+        if (t < line_free_us_) t = line_free_us_;
+        uint64_t byte_us_x1000 = cfg.baud ? 10ull * 1000000ull * 1000ull / cfg.baud : 0;   // 每字节时间，放大 1000 倍避免累计误差
+        bool garble = cfg.baud && cfg.rx_baud && cfg.rx_baud != cfg.baud;
+        for (size_t i = 0; i < n; i++) {
+            stats_.bytes_in++;
+            frac_ += byte_us_x1000;
+            t += frac_ / 1000;
+            frac_ %= 1000;
+            if (cfg.loss_ppm && next() % 1000000 < cfg.loss_ppm) {
+                stats_.lost++;
+                continue;
+            }
+            uint8_t b = data[i];
+            if (garble) {
+                b = (uint8_t)next();
+                stats_.garbled++;
+            } else if (cfg.flip_ppm && next() % 1000000 < cfg.flip_ppm) {
+                b ^= (uint8_t)(1u << (next() & 7));
+                stats_.flipped++;
+            }
+            if (tail_ - head_ == AR_LINK_SIM_BUF) {
+                stats_.overrun++;
+                continue;
+            }
+            at_[tail_ & (AR_LINK_SIM_BUF - 1)] = t;
+            val_[tail_ & (AR_LINK_SIM_BUF - 1)] = b;
+            tail_++;
+        }
+        line_free_us_ = t;
+    }
+
+    // 读出 now_us 之前已经到达的字节，返回个数
+    size_t read(uint8_t *out, size_t cap, uint64_t now_us)
+    {
+        size_t n = 0;
+        while (n < cap && head_ != tail_ && at_[head_ & (AR_LINK_SIM_BUF - 1)] <= now_us) {
+            out[n++] = val_[head_ & (AR_LINK_SIM_BUF - 1)];
+            head_++;
+        }
+        stats_.bytes_out += n;
+        return n;
+    }
+
+    // 到达时间不减，二分找第一个还没到的字节
+    size_t available(uint64_t now_us) const
+    {
+        size_t lo = 0, hi = tail_ - head_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (at_[(head_ + mid) & (AR_LINK_SIM_BUF - 1)] <= now_us) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // now_us 之后下一个字节到达的时间，没有时返回 0
+    uint64_t next_arrival_us(uint64_t now_us) const
+    {
+        size_t i = available(now_us);
+        return i < tail_ - head_ ? at_[(head_ + i) & (AR_LINK_SIM_BUF - 1)] : 0;
+    }
+
+    // 最后一个在途字节到达的时间，没有在途字节时返回 0
+    uint64_t drain_us() const { return head_ == tail_ ? 0 : at_[(tail_ - 1) & (AR_LINK_SIM_BUF - 1)]; }
+
+    // 对端复位或者驱动清空接收缓冲
+    void clear() { head_ = tail_; }
+
+    const SimPipeStats &stats() const { return stats_; }
+
+private:
+    uint64_t at_[AR_LINK_SIM_BUF];       // 每个字节到达的时间
+    uint8_t val_[AR_LINK_SIM_BUF];
+    size_t head_ = 0, tail_ = 0;         // 累计读出、写入的字节数
+    uint64_t line_free_us_ = 0;
+    uint64_t frac_ = 0;
+    uint32_t rng_ = 1;
+    SimPipeStats stats_ = {};
+
+    uint32_t next()                      // xorshift32
+    {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return rng_;
+    }
+};
+
+// 一对方向的串口线
+struct SimLink {
+    SimPipe s3_to_c3;
+    SimPipe c3_to_s3;
+
+    explicit SimLink(uint32_t baud = 115200) : s3_to_c3(baud), c3_to_s3(baud) {}
+
+    void set_baud(uint32_t baud)
+    {
+        s3_to_c3.cfg.baud = baud;
+        c3_to_s3.cfg.baud = baud;
+    }
+};
+
+}  // namespace ar_link
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * @Description: 串口链路统计，两个工程共用，只有头文件
+ *
+ * 每帧只做几次加法和一次 clz，开着也几乎不占 CPU；
+ * 编译时加 -DAR_LINK_STATS=0 整个关掉，AR_STAT() 里的语句不会生成任何代码。
+ *
+ * 延迟直方图按 log2 分桶：桶 i 统计 [2^(i-1), 2^i) us，桶 0 是 0 us，最后一个桶收所有更大的值。
+ * 两个直方图在两端的含义：
+ *   S3  transit  发出 -> 收到 ACK（端到端）      process  在发送队列里等信用的时间
+ *   C3  transit  收到 -> loop() 应用到 LVGL      process  应用 -> 刷到屏上
+ */
+#ifndef AR_LINK_STATS_H
+#define AR_LINK_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef AR_LINK_STATS
+#define AR_LINK_STATS 1
+#endif
+
+#if AR_LINK_STATS
+#define AR_STAT(x) do { x; } while (0)
+#else
+#define AR_STAT(x) do { } while (0)
+#endif
+
+#define AR_LINK_STATS_REQ     0x86   // S3->C3  请求统计，不带数据
+#define AR_LINK_STATS_REPORT  0x87   // C3->S3  data: LinkStats 原样（两边都是小端 32 位）
+
+#define AR_LINK_STATS_CTRL    16     // 控制帧 0x80~0x8F 各占一格（26~41），现在用到 0x8B
+#define AR_LINK_STATS_TYPES   (26 + AR_LINK_STATS_CTRL + 1)   // 'a'~'z' 占 0~25，最后一格收其他类型
+#define AR_LINK_STATS_BUCKETS 16     // 最后一个桶是 >= 16ms
+
+namespace ar_link {
+
+struct LinkStats {
+    uint32_t version;                              // sizeof(LinkStats)，两端不一致时不解析
+    uint32_t rx_frames[AR_LINK_STATS_TYPES];
+    uint32_t rx_bytes[AR_LINK_STATS_TYPES];
+    uint32_t tx_frames[AR_LINK_STATS_TYPES];
+    uint32_t tx_bytes[AR_LINK_STATS_TYPES];
+    uint32_t crc_errors;
+    uint32_t len_errors;
+    uint32_t resyncs;
+    uint32_t skipped;
+    uint32_t queue_high;                           // 队列深度最大值（S3 发送队列帧数，C3 帧环字节数）
+    uint32_t drops;                                // 队列满丢掉的帧
+    uint32_t superseded;                           // 被新帧作废的帧（只有 S3）
+    uint32_t transit[AR_LINK_STATS_BUCKETS];
+    uint32_t process[AR_LINK_STATS_BUCKETS];
+};
+
+inline int stats_type_slot(uint8_t type)
+{
+    if (type >= 'a' && type <= 'z') return type - 'a';
+    if (type >= 0x80 && type < 0x80 + AR_LINK_STATS_CTRL) return 26 + type - 0x80;
+    return AR_LINK_STATS_TYPES - 1;
+}
+
+inline char stats_type_name(int slot)
+{
+    if (slot < 26) return 'a' + slot;
+    if (slot < 26 + AR_LINK_STATS_CTRL) return "0123456789ABCDEF"[slot - 26];   // 控制帧显示成类型的低 4 位
+    return '?';
+}
+
+inline void stats_count(uint32_t *frames, uint32_t *bytes, uint8_t type, size_t len)
+{
+    int slot = stats_type_slot(type);
+    frames[slot]++;
+    bytes[slot] += len;
+}
+
+inline void stats_hist(uint32_t *hist, uint32_t us)
+{
+    int b = us ? 32 - __builtin_clz(us) : 0;
+    hist[b < AR_LINK_STATS_BUCKETS ? b : AR_LINK_STATS_BUCKETS - 1]++;
+}
+
+inline void stats_high(uint32_t *high, uint32_t value)
+{
+    if (value > *high) *high = value;
+}
+
+// 格式化成紧凑文本，只列出非 0 的项，给 BLE 读；返回写入长度
+inline size_t stats_format(const LinkStats &s, const char *name, char *out, size_t cap)
+{
+    size_t n = 0;
+#define AR_STATS_PUT(...)                                          \
+    do {                                                           \
+        if (n < cap) {                                             \
+            int r = snprintf(out + n, cap - n, __VA_ARGS__);       \
+            n += r > 0 ? r : 0;                                    \
+            if (n > cap) n = cap;                                  \
+        }                                                          \
+    } while (0)
+    AR_STATS_PUT("%s crc%lu len%lu resync%lu skip%lu qmax%lu drop%lu sup%lu\n", name,
+                 (unsigned long)s.crc_errors, (unsigned long)s.len_errors, (unsigned long)s.resyncs,
+                 (unsigned long)s.skipped, (unsigned long)s.queue_high, (unsigned long)s.drops,
+                 (unsigned long)s.superseded);
+    AR_STATS_PUT("rx");
+    for (int i = 0; i < AR_LINK_STATS_TYPES; i++) {
+        if (s.rx_frames[i]) AR_STATS_PUT(" %c%lu/%lu", stats_type_name(i), (unsigned long)s.rx_frames[i], (unsigned long)s.rx_bytes[i]);
+    }
+    AR_STATS_PUT("\ntx");
+    for (int i = 0; i < AR_LINK_STATS_TYPES; i++) {
+        if (s.tx_frames[i]) AR_STATS_PUT(" %c%lu/%lu", stats_type_name(i), (unsigned long)s.tx_frames[i], (unsigned long)s.tx_bytes[i]);
+    }
+    AR_STATS_PUT("\ntr");
+    for (int i = 0; i < AR_LINK_STATS_BUCKETS; i++) {
+        if (s.transit[i]) AR_STATS_PUT(" %d:%lu", i, (unsigned long)s.transit[i]);
+    }
+    AR_STATS_PUT("\npr");
+    for (int i = 0; i < AR_LINK_STATS_BUCKETS; i++) {
+        if (s.process[i]) AR_STATS_PUT(" %d:%lu", i, (unsigned long)s.process[i]);
+    }
+    AR_STATS_PUT("\n");
+#undef AR_STATS_PUT
+    return n < cap ? n : cap - 1;
+}
+
+}  // namespace ar_link
+
+#endif
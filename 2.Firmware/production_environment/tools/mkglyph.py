@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# 从 TTF/OTF 生成 S3 字形服务用的 SD 卡字库（格式见 AR_glass/src/my_glyph.h）
+#
+# 用法：
+#   pip install freetype-py
+#   python3 mkglyph.py AlibabaPuHuiTi-Regular.ttf 20 glyph20.agf
+#   python3 mkglyph.py AlibabaPuHuiTi-Regular.ttf 20 glyph20.agf --range 0x4e00-0x9fff --range 0x3000-0x303f
+# 字号要和 C3 固件里的 lv_font_AlibabaPuHuiTi_20 一样，生成的文件拷到 SD 卡的 /font/glyph20.agf。
+import argparse
+import struct
+
+import freetype
+
+DEFAULT_RANGES = [(0x00a0, 0x00ff), (0x2000, 0x206f), (0x3000, 0x303f), (0x4e00, 0x9fff), (0xff00, 0xffef)]
+BOX_MAX = 32
+
+
+def parse_range(s):
+    a, _, b = s.partition('-')
+    return int(a, 0), int(b or a, 0)
+
+
+def render(face, cp):
+    if face.get_char_index(cp) == 0:
+        return None
+    face.load_char(cp, freetype.FT_LOAD_RENDER | freetype.FT_LOAD_TARGET_NORMAL)
+    g = face.glyph
+    bm = g.bitmap
+    w, h = bm.width, bm.rows
+    if w > BOX_MAX or h > BOX_MAX:
+        return None
+    # 4 bpp，高 4 位在前，行与行之间不补齐
+    px = []
+    for y in range(h):
+        row = bm.buffer[y * bm.pitch: y * bm.pitch + w]
+        px.extend(v >> 4 for v in row)
+    if len(px) % 2:
+        px.append(0)
+    bitmap = bytes((px[i] << 4) | px[i + 1] for i in range(0, len(px), 2))
+    adv = (g.advance.x + 32) >> 6
+    ofs_x = g.bitmap_left
+    ofs_y = g.bitmap_top - h              # LVGL 的 ofs_y 是基线到字形底部，向上为正
+    return struct.pack('<BBBbb', min(adv, 255), w, h, ofs_x, ofs_y) + bitmap
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('font')
+    ap.add_argument('size', type=int)
+    ap.add_argument('out')
+    ap.add_argument('--range', action='append', type=parse_range, help='码点范围，如 0x4e00-0x9fff，可以写多个')
+    args = ap.parse_args()
+
+    face = freetype.Face(args.font)
+    face.set_pixel_sizes(0, args.size)
+    line_height = (face.size.ascender - face.size.descender) >> 6
+    base_line = -face.size.descender >> 6
+
+    glyphs = []
+    for a, b in args.range or DEFAULT_RANGES:
+        for cp in range(a, min(b, 0xffff) + 1):
+            rec = render(face, cp)
+            if rec is not None:
+                glyphs.append((cp, rec))
+    glyphs.sort()
+
+    count = len(glyphs)
+    hdr = b'AGF1' + struct.pack('<IHHB3x', count, line_height, base_line, 4)
+    data_start = len(hdr) + count * 2 + count * 4
+    cps = b''.join(struct.pack('<H', cp) for cp, _ in glyphs)
+    offsets = []
+    pos = data_start
+    for _, rec in glyphs:
+        offsets.append(pos)
+        pos += len(rec)
+    with open(args.out, 'wb') as f:
+        f.write(hdr)
+        f.write(cps)
+        f.write(b''.join(struct.pack('<I', o) for o in offsets))
+        for _, rec in glyphs:
+            f.write(rec)
+    print('%d 个字, 行高 %d, 基线 %d, %d 字节' % (count, line_height, base_line, pos))
+
+
+if __name__ == '__main__':
+    main()